@@ -0,0 +1,163 @@
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+char *StringArena;
+
+static uint32_t ArenaSize, ArenaCapacity;
+
+/* Offsets of interned strings. Open addressing, 0 marks an empty slot. */
+static uint32_t *InternTable;
+static uint32_t InternTableSize, InternCount;
+
+uint32_t SA_HashString(const char *String) {
+  uint32_t Hash = 2166136261u; /* FNV-1a */
+
+  while (*String) {
+    Hash ^= (uint8_t)*String++;
+    Hash *= 16777619u;
+  }
+
+  return Hash;
+}
+
+static void InternTableResize(uint32_t Size) {
+  uint32_t *l_Table = calloc(Size, sizeof(uint32_t));
+
+  if (!l_Table) {
+    SDL_Log("[FATAL]: Unable to allocate the intern table.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (uint32_t i = 0; i < InternTableSize; i++) {
+    if (InternTable[i] == 0)
+      continue;
+
+    uint32_t Slot = SA_HashString(StringArena + InternTable[i]) & (Size - 1);
+
+    while (l_Table[Slot] != 0)
+      Slot = (Slot + 1) & (Size - 1);
+
+    l_Table[Slot] = InternTable[i];
+  }
+
+  free(InternTable);
+  InternTable = l_Table;
+  InternTableSize = Size;
+}
+
+void InitializeArena() {
+  ArenaCapacity = 64 * 1024;
+  StringArena = malloc(ArenaCapacity);
+
+  if (!StringArena) {
+    SDL_Log("[FATAL]: Unable to allocate the string arena.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  StringArena[0] = '\0';
+  ArenaSize = 1;
+
+  InternTableResize(1024);
+}
+
+uint32_t SA_InternString(const char *String) {
+  if (String == NULL || String[0] == 0)
+    return 0;
+
+  uint32_t Mask = InternTableSize - 1;
+  uint32_t Slot = SA_HashString(String) & Mask;
+
+  for (; InternTable[Slot] != 0; Slot = (Slot + 1) & Mask) {
+    if (strcmp(StringArena + InternTable[Slot], String) == 0)
+      return InternTable[Slot];
+  }
+
+  size_t Length = strlen(String) + 1;
+
+  if (ArenaSize + Length > ArenaCapacity) {
+    /* String may itself point into the arena (a suffix of a path, for example). */
+    bool Inside = String >= StringArena && String < StringArena + ArenaSize;
+    size_t InsideOffset = Inside ? (size_t)(String - StringArena) : 0;
+
+    uint32_t Capacity = ArenaCapacity;
+
+    /* Doubling while small, then 1.5x, since a large library already has most of its strings. */
+    while (ArenaSize + Length > Capacity)
+      Capacity += Capacity < (16 << 20) ? Capacity : Capacity / 2;
+
+    char *l_Arena = realloc(StringArena, Capacity);
+
+    if (!l_Arena) {
+      SDL_Log("[FATAL]: Unable to realloc the string arena.\n");
+      exit(EXIT_FAILURE);
+    }
+
+    StringArena = l_Arena;
+    ArenaCapacity = Capacity;
+
+    if (Inside)
+      String = StringArena + InsideOffset;
+  }
+
+  uint32_t Offset = ArenaSize;
+
+  memcpy(StringArena + Offset, String, Length);
+  ArenaSize += Length;
+  InternTable[Slot] = Offset;
+
+  if (++InternCount * 2 > InternTableSize)
+    InternTableResize(InternTableSize * 2);
+
+  return Offset;
+}
+
+uint32_t SA_ArenaSize() {
+  return ArenaSize;
+}
+
+/* Replaces the arena with a saved one. Strings holds the NUL separated strings of an earlier arena,
+ * starting with "", so offsets taken from it stay valid. Anything interned before is dropped. */
+void SA_ArenaLoad(const char *Strings, uint32_t Length) {
+  if (Length > ArenaCapacity) {
+    char *l_Arena = realloc(StringArena, Length);
+
+    if (!l_Arena) {
+      SDL_Log("[FATAL]: Unable to realloc the string arena.\n");
+      exit(EXIT_FAILURE);
+    }
+
+    StringArena = l_Arena;
+    ArenaCapacity = Length;
+  }
+
+  memcpy(StringArena, Strings, Length);
+  ArenaSize = Length;
+
+  uint32_t Count = 0;
+
+  for (uint32_t Offset = 1; Offset < ArenaSize; Offset += strlen(StringArena + Offset) + 1)
+    Count++;
+
+  uint32_t Size = 1024;
+
+  while (Size < Count * 2 + 2)
+    Size *= 2;
+
+  free(InternTable);
+  InternTable = NULL;
+  InternTableSize = 0;
+  InternCount = Count;
+  InternTableResize(Size);
+
+  for (uint32_t Offset = 1; Offset < ArenaSize; Offset += strlen(StringArena + Offset) + 1) {
+    uint32_t Slot = SA_HashString(StringArena + Offset) & (Size - 1);
+
+    while (InternTable[Slot] != 0)
+      Slot = (Slot + 1) & (Size - 1);
+
+    InternTable[Slot] = Offset;
+  }
+}
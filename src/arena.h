@@ -0,0 +1,25 @@
+#ifndef __SAARENA__
+#define __SAARENA__
+
+#include <stdint.h>
+
+/*
+ * Every string owned by the library (paths, titles, tags, category names) lives in one packed,
+ * append-only buffer and is referred to by its offset. Identical strings are interned, so the
+ * thousands of "N/A" tags and repeated album names are stored once. Offset 0 is always "".
+ * Pointers returned by SA_String are invalidated by the next SA_InternString call.
+ */
+
+extern char *StringArena;
+
+void InitializeArena();
+uint32_t SA_HashString(const char *String);
+uint32_t SA_InternString(const char *String);
+uint32_t SA_ArenaSize();
+void SA_ArenaLoad(const char *Strings, uint32_t Length);
+
+static inline const char *SA_String(uint32_t Offset) {
+  return StringArena + Offset;
+}
+
+#endif
@@ -12,27 +12,179 @@ const char *PathDelimiter = "\\";
 #endif
 
 #include "discord.h"
+#include "arena.h"
+#include "cache.h"
+#include "category.h"
+#include "content.h"
+#include "crossfade.h"
+#include "decoder.h"
+#include "equalizer.h"
+#include "order.h"
+#include "playlist.h"
+#include "preload.h"
+#include "queue.h"
+#include "search.h"
 #include "gui.h"
 #include "audio.h"
 
+/* Float output, so crossfades and the equalizer can work on SDL_mixer's output without converting */
 static SDL_AudioSpec Specifications = {
   .freq = MIX_DEFAULT_FREQUENCY,
-  .format = MIX_DEFAULT_FORMAT,
+  .format = SDL_AUDIO_F32,
   .channels = MIX_DEFAULT_CHANNELS
 };
 
 AudioData *Audio;
 
-bool LoopLock = false; /* Used for LOOP_ALL functionality */
-
 uint32_t SA_TotalAudio = 2;
+uint32_t AudioFinishedEvent;
 int32_t AudioVolume = MIX_MAX_VOLUME, AudioCurrentIndex = -1;
 
 static Mix_Music *Music;
+static int32_t MusicIndex = -1; /* The track Music was opened for, -1 once it's gone from the library */
+
+/* When the last track ran out, in microseconds (wrapping), 0 if none did since the last start. Set
+ * from the mixer thread, it times the gap to the next track. */
+static SDL_AtomicInt FinishedAt;
+
+/* Path -> Audio index lookup. Open addressing with linear probing; the table is kept at
+ * twice the size of the Audio buffer so probes stay short. Empty slots hold -1. */
+static int32_t *PathTable;
+static uint32_t PathTableSize;
+
+/* Stack of vacated Audio slots. AudioRemove pushes, InsertAudio pops, and growing the
+ * Audio buffer pushes the new slots in reverse so the lowest index is handed out first. */
+static uint32_t *FreeSlots;
+static uint32_t FreeSlotCount;
+
+/* Open batches, and whether the library changed since the playlist was last rebuilt by one */
+static uint32_t BatchDepth;
+static bool BatchDirty;
 
 double AudioDuration = 0, AudioPosition = 0;
 
-char *AudioCurrentPath = NULL;
+static void PathTableInsert(uint32_t Index) {
+  uint32_t Mask = PathTableSize - 1;
+  uint32_t Slot = SA_HashString(SA_String(Audio[Index].Path)) & Mask;
+
+  while (PathTable[Slot] != -1)
+    Slot = (Slot + 1) & Mask;
+
+  PathTable[Slot] = Index;
+}
+
+static void PathTableRemove(uint32_t Index) {
+  uint32_t Mask = PathTableSize - 1;
+  uint32_t Slot = SA_HashString(SA_String(Audio[Index].Path)) & Mask;
+
+  while (PathTable[Slot] != (int32_t)Index) {
+    if (PathTable[Slot] == -1)
+      return;
+
+    Slot = (Slot + 1) & Mask;
+  }
+
+  /* Backward shift deletion, so lookups never need tombstones. */
+  uint32_t Next = (Slot + 1) & Mask;
+
+  while (PathTable[Next] != -1) {
+    uint32_t Home = SA_HashString(SA_String(Audio[PathTable[Next]].Path)) & Mask;
+
+    if (((Next - Home) & Mask) >= ((Next - Slot) & Mask)) {
+      PathTable[Slot] = PathTable[Next];
+      Slot = Next;
+    }
+
+    Next = (Next + 1) & Mask;
+  }
+
+  PathTable[Slot] = -1;
+}
+
+static void PathTableResize(uint32_t Size) {
+  int32_t *l_Table = malloc(sizeof(int32_t) * Size);
+
+  if (!l_Table) {
+    SDL_Log("Failed to allocate the path lookup table.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  free(PathTable);
+  memset(l_Table, 0xff, sizeof(int32_t) * Size);
+
+  PathTable = l_Table;
+  PathTableSize = Size;
+
+  for (uint32_t i = 0; i < SA_TotalAudio; i++)
+    if (Audio[i].Path != 0)
+      PathTableInsert(i);
+}
+
+static void PushFreeSlots(uint32_t From, uint32_t To) {
+  for (uint32_t i = To; i > From; i--)
+    FreeSlots[FreeSlotCount++] = i - 1;
+}
+
+/* The path table stays a power of two at least twice the size of the Audio buffer. */
+static void PathTableFit() {
+  uint32_t Size = PathTableSize ? PathTableSize : 4;
+
+  while (Size < SA_TotalAudio * 2)
+    Size *= 2;
+
+  if (Size != PathTableSize)
+    PathTableResize(Size);
+}
+
+static void GrowAudio(uint32_t NewTotal) {
+  uint32_t OldTotal = SA_TotalAudio;
+  AudioData *l_Audio = realloc(Audio, sizeof(AudioData) * NewTotal);
+  
+  if (!l_Audio) {
+    SDL_Log("Failed to reallocate Audio buffer during AddAudio call.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  uint32_t *l_FreeSlots = realloc(FreeSlots, sizeof(uint32_t) * NewTotal);
+
+  if (!l_FreeSlots) {
+    SDL_Log("Failed to reallocate FreeSlots buffer during AddAudio call.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  memset(&l_Audio[OldTotal], 0, sizeof(AudioData) * (NewTotal - OldTotal));
+
+  SA_TotalAudio = NewTotal;
+  Audio = l_Audio;
+  FreeSlots = l_FreeSlots;
+
+  PushFreeSlots(OldTotal, SA_TotalAudio);
+  SA_OrderResize(SA_TotalAudio);
+  SA_QueueResize(SA_TotalAudio);
+  SA_CacheResize(SA_TotalAudio);
+  SA_ContentResize(SA_TotalAudio);
+  SA_SearchResize(SA_TotalAudio);
+  PathTableFit();
+}
+
+/* Runs on the mixer thread, right as the music stream ends (or on the main thread, inside
+ * Mix_HaltMusic). SDL_mixer can't be called from here, so the main loop is woken up instead. */
+static void MusicFinished() {
+  uint32_t Now = SDL_GetTicksNS() / 1000;
+  SDL_Event Event = {.type = AudioFinishedEvent};
+
+  SDL_SetAtomicInt(&FinishedAt, Now ? Now : 1);
+  SDL_PushEvent(&Event);
+}
+
+/* Runs on the mixer thread with the whole mixed stream, in the format negotiated above */
+static void PostMix(void *Data, Uint8 *Stream, int Length) {
+  (void)Data;
+  uint32_t Frames = Length / (sizeof(float) * Specifications.channels);
+
+  SA_CrossfadeMix((float *)Stream, Frames);
+  SA_EqualizerProcess((float *)Stream, Frames);
+}
 
 void InitializeAudio() {
   if (!Mix_OpenAudio(0, &Specifications)) {
@@ -42,199 +194,392 @@ void InitializeAudio() {
     Mix_QuerySpec(&Specifications.freq, &Specifications.format, &Specifications.channels);
   }
   
-  Audio = malloc(sizeof(AudioData) * SA_TotalAudio);
+  InitializeArena();
+  InitializeCategories();
+  SA_OrderResize(SA_TotalAudio);
+  SA_QueueResize(SA_TotalAudio);
+  SA_CacheResize(SA_TotalAudio);
+  SA_ContentResize(SA_TotalAudio);
+  InitializeSearch();
+  SA_SearchResize(SA_TotalAudio);
+  Audio = calloc(SA_TotalAudio, sizeof(AudioData));
   
+  if (!Audio) {
+    SDL_Log("Failed to allocate Audio buffer.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  FreeSlots = malloc(sizeof(uint32_t) * SA_TotalAudio);
+
+  if (!FreeSlots) {
+    SDL_Log("Failed to allocate FreeSlots buffer.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  PushFreeSlots(0, SA_TotalAudio);
+  PathTableFit();
+
+  AudioFinishedEvent = SDL_RegisterEvents(1);
+
+  if (AudioFinishedEvent == 0) {
+    SDL_Log("Failed to register the end of track event: %s\n", SDL_GetError());
+    exit(EXIT_FAILURE);
+  }
+
   Mix_VolumeMusic(AudioVolume);
+  Mix_HookMusicFinished(MusicFinished);
+
+  InitializeCrossfade(Specifications.freq, Specifications.format == SDL_AUDIO_F32, Specifications.channels);
+
+  if (Specifications.format == SDL_AUDIO_F32) {
+    InitializeEqualizer(Specifications.freq, Specifications.channels);
+    Mix_SetPostMix(PostMix, NULL);
+  }
+}
+
+/* Keeps a removed or changed track's handle from being cached, or found under a reused slot. */
+static void ForgetMusic(uint32_t Index) {
+  SA_DecoderForget(Index);
+  SA_PreloadForget(Index);
+  SA_CrossfadeForget(Index);
+
+  if (MusicIndex == (int32_t)Index)
+    MusicIndex = -1;
 }
 
 void AudioRemove(uint32_t Index) {
-  if (Index == SA_TotalAudio || Audio[Index].Path[0] == 0)
+  if (Index >= SA_TotalAudio || Audio[Index].Path == 0)
     return;
   
+  PathTableRemove(Index);
+  SA_SearchRemove(Index);
+  SA_QueueRemove(Index);
+  SA_CategoryRemove(Audio[Index].Category, Index);
+  SA_ContentSet(Index, 0);
+  SA_PlaylistRemove(Index);
+  ForgetMusic(Index);
   memset(&Audio[Index], 0, sizeof(AudioData));
+  FreeSlots[FreeSlotCount++] = Index;
+  BatchDirty = true;
+}
 
-  for (uint32_t i = Index + 1; i < SA_TotalAudio; i++) {
-    if (Audio[Index].Path[0] == 0)
-      continue;
+/* Makes room for Count more tracks at once, so a bulk insert doesn't rehash on every growth step. */
+void ReserveAudio(uint32_t Count) {
+  if (FreeSlotCount >= Count)
+    return;
 
-    Audio[Index].LayoutOrder -= 1;
-  }
+  uint32_t NewTotal = SA_TotalAudio;
+
+  while (NewTotal - SA_TotalAudio + FreeSlotCount < Count)
+    NewTotal = SA_GrowCapacity(NewTotal);
+
+  GrowAudio(NewTotal);
 }
 
 int32_t GetEmptyIndex() {
-  for (uint32_t i = 0; i < SA_TotalAudio; i++)
-    if (Audio[i].Path[0] == 0)
-      return i;
-  return -1;
+  if (FreeSlotCount == 0)
+    GrowAudio(SA_GrowCapacity(SA_TotalAudio));
+
+  return FreeSlots[--FreeSlotCount];
 }
 
-int32_t GetNextIndex(uint32_t Index) {
-  uint32_t LayoutOrder = Audio[Index].LayoutOrder;
+int32_t GetAudioIndex(const char *Path) {
+  if (Path == NULL)
+    return -1;
 
-  for (uint32_t i = 0; i < SA_TotalAudio; i++) {
-    if (Audio[Index].Path[0] == 0)
-      continue;
+  uint32_t Mask = PathTableSize - 1;
+  
+  for (uint32_t Slot = SA_HashString(Path) & Mask; PathTable[Slot] != -1; Slot = (Slot + 1) & Mask) {
+    if (strcmp(SA_String(Audio[PathTable[Slot]].Path), Path) == 0)
+      return PathTable[Slot];
+  }
 
-    if (Audio[i].LayoutOrder <= LayoutOrder)
-      continue;
+  return -1;
+}
+
+/* Interns the tags of a track whose Path is set. Empty tags fall back to the file name or "N/A". */
+static void SetAudioTags(uint32_t Index, const char *Title, const char *Artist, const char *Album, const char *Copyright) {
+  if (Title == NULL || Title[0] == 0) {
+    SDL_Log("WARNING: LocalTagTitle is empty.");
 
-    if (strcmp(Audio[Index].AssignedList, Audio[i].AssignedList) == 0)
-      return i;
+    const char *LocalPath = SA_String(Audio[Index].Path);
+    Title = LocalPath;
+    
+    while (*(LocalPath += strspn(LocalPath, PathDelimiter)) != '\0') {
+      size_t Length = strcspn(LocalPath, PathDelimiter);
+      Title = LocalPath;
+      LocalPath += Length;
+    }
   }
   
-  return 0; /* Fallback return */
+  if (Artist == NULL || Artist[0] == 0) {Artist = "N/A";}
+  if (Copyright == NULL || Copyright[0] == 0) {Copyright = "N/A";}
+  if (Album == NULL || Album[0] == 0) {Album = "N/A";}
+
+  Audio[Index].Title = SA_InternString(Title);
+  Audio[Index].TagArtist = SA_InternString(Artist);
+  Audio[Index].TagAlbum = SA_InternString(Album);
+  Audio[Index].TagCopyright = SA_InternString(Copyright);
 }
 
-int32_t GetAudioIndex(char *Path) {
-  if (Path == NULL)
+static void LinkAudio(uint32_t Index, uint8_t Category) {
+  SA_CategoryAppend(Category, Index);
+  SA_QueueInsert(Index);
+  SA_SearchInsert(Index);
+  PathTableInsert(Index);
+  BatchDirty = true;
+}
+
+/* Inserts a track from already known metadata. */
+int32_t InsertAudio(const char *Path, const char *Title, const char *Artist, const char *Album, const char *Copyright, const char *Category) {
+  if (GetAudioIndex(Path) != -1) {
+    SDL_Log("\"%s\" is already loaded.", Path);
     return -1;
+  }
 
-  for (uint32_t i = 0; i < SA_TotalAudio; i++) {
-    if (Audio[i].Path[0] == 0)
-      continue;
+  int32_t CategoryID = SA_CreateCategory((Category == NULL || *Category == '\0') ? "All" : Category);
 
-    if (strcmp(Audio[i].Path, Path) == 0)
-      return i;
+  if (CategoryID == -1) {
+    SDL_Log("No room for category \"%s\", adding \"%s\" to All.", Category, Path);
+    CategoryID = 0;
   }
 
-  return -1;
+  int32_t Index = GetEmptyIndex();
+
+  Audio[Index].Path = SA_InternString(Path);
+  SetAudioTags(Index, Title, Artist, Album, Copyright);
+  LinkAudio(Index, CategoryID);
+
+  return Index;
 }
 
-int32_t AddAudio(char *Path, char *Category) {
-  if (GetAudioIndex(Path) != -1) {
-    SDL_Log("\"%s\" is already loaded.", Path);
-    return -1;
+/* Moves a track to the end of Category, as a playlist import does with tracks it finds in the library. */
+void MoveAudio(uint32_t Index, uint8_t Category) {
+  if (Audio[Index].Category == Category) {
+    SA_CategoryMove(Category, Index, Categories[Category].Count - 1);
+  } else {
+    SA_CategoryRemove(Audio[Index].Category, Index);
+    SA_CategoryAppend(Category, Index);
   }
-  
-  Category = Category == NULL ? "All" : Category;
 
-  int32_t Index = GetEmptyIndex();
-  Mix_Music *l_Music;
+  SA_QueueRemove(Index);
+  SA_QueueInsert(Index);
+  BatchDirty = true;
+}
 
-  const char *TagArtist = NULL;
-  const char *TagAlbum = NULL;
-  const char *TagCopyright = NULL;
+/* Re-keys a track whose file was moved or renamed, keeping its tags, position and category. */
+void RenameAudio(uint32_t Index, const char *Path) {
+  ForgetMusic(Index);
+  PathTableRemove(Index);
+  Audio[Index].Path = SA_InternString(Path);
+  PathTableInsert(Index);
+  BatchDirty = true;
+}
 
-  if (Index == -1) {
-    AudioData *l_Audio = realloc(Audio, sizeof(AudioData) * (SA_TotalAudio * 2));
-    Index = SA_TotalAudio;
-    
-    if (!l_Audio) {
-      SDL_Log("Failed to reallocate Audio buffer during AddAudio call.\n");
-      exit(EXIT_FAILURE);
-    }
+/* Re-reads the tags of a track in place, keeping its position and category. */
+void UpdateAudio(uint32_t Index, const char *Title, const char *Artist, const char *Album, const char *Copyright) {
+  ForgetMusic(Index);
+  SA_SearchRemove(Index);
+  SetAudioTags(Index, Title, Artist, Album, Copyright);
+  SA_SearchInsert(Index);
+  BatchDirty = true;
+}
 
-    for (uint16_t i = SA_TotalAudio; i < SA_TotalAudio * 2; i++)
-      memset(&l_Audio[i], 0, sizeof(AudioData));
+/*
+ * RefreshPlaylist() walks the whole library, so adding tracks one refresh at a time is quadratic.
+ * Changes made between SA_BeginAudioBatch() and SA_CommitAudioBatch() share one refresh, done by
+ * the outermost commit and only if something did change. Batches nest.
+ */
+void SA_BeginAudioBatch() {
+  BatchDepth++;
+}
 
-    SA_TotalAudio *= 2;
-    Audio = l_Audio;
-  }
+void SA_CommitAudioBatch() {
+  if (BatchDepth > 0 && --BatchDepth > 0)
+    return;
 
-  l_Music = Mix_LoadMUS(Path);
+  SA_SearchCompact();
 
-  if (!l_Music) {
-    SDL_Log("Failed to load \"%s\": %s", Path, SDL_GetError());
-    return -1;
+  if (BatchDirty) {
+    BatchDirty = false;
+    RefreshPlaylist();
   }
+}
 
-  if (Mix_GetMusicTitle(l_Music)[0] != 0) {
-    char *MusicTitle = (char*)Mix_GetMusicTitle(l_Music);
+/* Inserts a track whose strings are already in the arena, as loaded from the library cache. */
+int32_t RestoreAudio(const AudioData *Data) {
+  if (GetAudioIndex(SA_String(Data->Path)) != -1)
+    return -1;
 
-    memcpy(Audio[Index].Title, MusicTitle, strlen(MusicTitle));
-  } else {
-    SDL_Log("WARNING: LocalTagTitle is empty.");
+  int32_t Index = GetEmptyIndex();
+
+  Audio[Index] = *Data;
+  LinkAudio(Index, Data->Category);
 
-    char *LocalPath = Path;
-    char *LastPathPointer;
-    
-    while (*(LocalPath += strspn(LocalPath, PathDelimiter)) != '\0') {
-      size_t Length = strcspn(LocalPath, PathDelimiter);
-      LastPathPointer = LocalPath;
-      LocalPath += Length;
-    }
-    
-    memcpy(Audio[Index].Title, LastPathPointer, strlen(LastPathPointer));
-  }
-  
-  TagArtist = Mix_GetMusicArtistTag(l_Music);
-  TagCopyright = Mix_GetMusicCopyrightTag(l_Music);
-  TagAlbum = Mix_GetMusicAlbumTag(l_Music);
-  
-  if (TagArtist[0] == 0) {TagArtist = "N/A";}
-  if (TagCopyright[0] == 0) {TagCopyright = "N/A";}
-  if (TagAlbum[0] == 0) {TagAlbum = "N/A";}
-
-  memcpy(Audio[Index].Path, Path, strlen(Path));
-  memcpy(Audio[Index].TagArtist, TagArtist, strlen(TagArtist));
-  memcpy(Audio[Index].TagAlbum, TagAlbum, strlen(TagAlbum));
-  memcpy(Audio[Index].TagCopyright, TagCopyright, strlen(TagCopyright));
-  memcpy(Audio[Index].AssignedList, Category, strlen(Category));
-  
-  Audio[Index].LayoutOrder = Index;
-  
-  RefreshPlaylist();
-  Mix_FreeMusic(l_Music);
   return Index;
 }
 
 void UpdateAudioPosition() {
-  if (Mix_PlayingMusic()) {
-    LoopLock = false;
+  if (Music != NULL && Mix_PlayingMusic())
     AudioPosition = Mix_GetMusicPosition(Music);
-  } else {
-    if (LoopStatus == LOOP_SONG) {
-      if (GetAudioIndex(AudioCurrentPath) != -1)
-        PlayAudio(AudioCurrentPath);
-    } else if (LoopStatus == LOOP_ALL && LoopLock == false) {
-      LoopLock = true;
-
-      if (GetAudioIndex(AudioCurrentPath) != -1)
-        PlayAudio(Audio[GetNextIndex(AudioCurrentIndex)].Path);
-    } else if (LoopStatus == LOOP_ALL && LoopLock == true) {
-      /* Probably not the best way to handle it */
-      if (GetAudioIndex(AudioCurrentPath) != -1)
-        PlayAudio(Audio[AudioCurrentIndex].Path);
-    } else if (LoopStatus == LOOP_NONE) {
-      Mix_FreeMusic(Music);
-
-      Music = NULL;
-      AudioCurrentIndex = -1;
-    }
-  }
+
+  /* Only looping over the queue moves on to the next track by itself */
+  int32_t Next = LoopStatus == LOOP_ALL && AudioCurrentIndex != -1 ? SA_QueuePeek(AudioCurrentIndex) : -1;
+  SA_CrossfadeUpdate(Next, AudioPosition, AudioDuration, PausedMusic, AudioVolume);
+}
+
+/* Opens the track after Index ahead of time, and decodes its start if crossfades are on. */
+static void PreloadNext(int32_t Index) {
+  int32_t Next = Index != -1 ? SA_QueuePeek(Index) : -1;
+
+  if (Next == -1 || Next == Index)
+    return;
+
+  uint8_t Parts = SA_DecoderContains(Next) ? 0 : PRELOAD_OPEN;
+
+  if (CrossfadeSeconds > 0 && Audio[Next].Duration > 0 && Audio[Next].Duration <= CROSSFADE_DECODE_LIMIT)
+    Parts |= PRELOAD_HEAD;
+
+  if (Parts)
+    SA_PreloadRequest(Next, SA_String(Audio[Next].Path), Parts);
+}
+
+void ConfigureCrossfade(float Seconds, uint8_t Curve) {
+  SA_CrossfadeConfigure(Seconds, Curve);
+  PreloadNext(AudioCurrentIndex);
+}
+
+static void StopAudio() {
+  if (MusicIndex != -1)
+    SA_DecoderPut(MusicIndex, Music);
+  else
+    Mix_FreeMusic(Music);
+
+  Music = NULL;
+  MusicIndex = -1;
+  AudioCurrentIndex = -1;
+  SDL_SetAtomicInt(&FinishedAt, 0);
+}
+
+/* Handles AudioFinishedEvent. The hook also fires when a track is halted to switch to another one
+ * while paused, so the event only counts if nothing is playing by the time it comes in. */
+void HandleAudioFinished() {
+  if (Music == NULL || PausedMusic || Mix_PlayingMusic())
+    return;
+
+  bool CurrentLoaded = AudioCurrentIndex != -1 && Audio[AudioCurrentIndex].Path != 0;
+  int32_t Next = -1;
+
+  if (LoopStatus == LOOP_SONG && CurrentLoaded)
+    Next = AudioCurrentIndex;
+  else if (LoopStatus == LOOP_ALL && CurrentLoaded)
+    Next = SA_QueueNext(AudioCurrentIndex);
+
+  /* A crossfade already playing the start of a track goes on with that one */
+  int32_t Incoming = SA_CrossfadeIncoming();
+
+  if (Incoming != -1 && LoopStatus == LOOP_ALL)
+    Next = Incoming;
+
+  /* A track that fails to open stops playback rather than leaving the finished one loaded */
+  if (Next == -1 || PlayAudio(SA_String(Audio[Next].Path)) != 0)
+    StopAudio();
 }
 
-int8_t PlayAudio(char *Path) {
+int8_t PlayAudio(const char *Path) {
+  /* Read first, a halt further down sets it again */
+  uint32_t Finished = SDL_GetAtomicInt(&FinishedAt);
   int Index = GetAudioIndex(Path);
 
+  /* Files the library doesn't have go through SA_ImportPlay() */
   if (Index == -1)
-    Index = AddAudio(Path, NULL);
+    return -1;
 
-  if (Music != NULL) {
-    Mix_FreeMusic(Music);
-    Music = NULL;
+  /* Playing a track outside the queue rebuilds it from that track's category */
+  if (!SA_QueueContains(Index))
+    SA_QueueBuild(Audio[Index].Category, Index);
+
+  Mix_Music *Previous = Music;
+  const char *Source = "replayed";
+
+  /* Replaying the current track rewinds its handle. Otherwise a recently played track's handle is
+   * still open, or the track after the last one was opened in the background. */
+  if (Previous == NULL || MusicIndex != Index) {
+    Source = "cached";
+    Music = SA_DecoderTake(Index);
+
+    if (!Music) {
+      Source = "preloaded";
+      Music = SA_PreloadTake(Index, SA_String(Audio[Index].Path));
+    }
+
+    if (!Music) {
+      Source = "opened on demand";
+      SDL_Log("Attempting to load \"%s\"", Path);
+      Music = Mix_LoadMUS(Path);
+    }
   }
-  
-  Music = Mix_LoadMUS(Path);
-  
-  SDL_Log("Attempting to load \"%s\"", Path);
 
-  if (Music) {
-    if (AudioCurrentIndex != Index)
-      UpdateActivityRPC(Audio[Index].Title, Audio[Index].TagArtist);
+  if (!Music) {
+    Music = Previous;
+    return -1;
+  }
+
+  if (Previous != NULL && Previous != Music) {
+    /* Mix_PlayMusic stops the previous track, but isn't called below while paused */
+    if (PausedMusic)
+      Mix_HaltMusic();
+
+    if (MusicIndex != -1)
+      SA_DecoderPut(MusicIndex, Previous);
+    else
+      Mix_FreeMusic(Previous);
+  }
 
-    AudioCurrentIndex = Index;
-    AudioCurrentPath = Path;
+  if (AudioCurrentIndex != Index)
+    UpdateActivityRPC((char *)SA_String(Audio[Index].Title), (char *)SA_String(Audio[Index].TagArtist));
+
+  AudioCurrentIndex = Index;
+  MusicIndex = Index;
+
+  /* The decoder's figure is the exact one; the one read at import stands in if it has none */
+  AudioDuration = Mix_MusicDuration(Music);
+
+  if (AudioDuration > 0)
+    Audio[Index].Duration = AudioDuration;
+  else
+    AudioDuration = Audio[Index].Duration > 0 ? Audio[Index].Duration : 0;
+  AudioPosition = 0;
+
+  /* Continuing a crossfade starts the decoder where the buffered start of the track got to. The
+   * lock keeps the mixer from moving on between the two. */
+  if (!PausedMusic && SA_CrossfadeIncoming() == Index) {
+    Source = "crossfaded";
+
+    Mix_LockAudio();
+    AudioPosition = SA_CrossfadeHandover();
+    Mix_PlayMusic(Music, 0);
+    Mix_SetMusicPosition(AudioPosition);
+    Mix_UnlockAudio();
+  } else {
+    SA_CrossfadeCancel();
 
-    AudioDuration = Mix_MusicDuration(Music);
-    AudioPosition = 0;
-    
     if (!PausedMusic)
       Mix_PlayMusic(Music, 0);
     Mix_SetMusicPosition(0);
-
-    return 0;
   }
-  
-  return -1;
+
+  SDL_SetAtomicInt(&FinishedAt, 0);
+
+  #ifndef NDEBUG
+  if (Finished != 0)
+    SDL_Log("[STATS]: %.2f ms gap before \"%s\" (%s).", (uint32_t)(SDL_GetTicksNS() / 1000 - Finished) / 1000.0,
+            SA_String(Audio[Index].Title), Source);
+  #else
+  (void)Finished;
+  (void)Source;
+  #endif
+
+  PreloadNext(Index);
+  return 0;
 }
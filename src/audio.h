@@ -2,6 +2,7 @@
 #define __PAPAUDIO__
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifndef WINDOWS
 #include <linux/limits.h>
@@ -9,29 +10,57 @@
 #include <windows.h>
 #endif
 
+/*
+ * Only the fields scanned by the playlist and the loop logic are kept inline. Strings are offsets
+ * into the string arena (see arena.h); a slot with Path == 0 is unused.
+ */
 typedef struct {
-  char Title[128];
-  char Path[PATH_MAX];
+  uint32_t Path;
+  uint32_t Title;
   
-  char TagArtist[128];
-  char TagCopyright[128];
-  char TagAlbum[128];
+  uint32_t TagArtist;
+  uint32_t TagCopyright;
+  uint32_t TagAlbum;
 
-  char AssignedList[128];
+  uint8_t Category; /* Layout order is kept by the category, see category.h */
 
-  uint32_t LayoutOrder;
+  float Duration; /* Seconds; 0 if never read, AUDIO_DURATION_UNKNOWN if it couldn't be worked out */
 } AudioData;
 
+#define AUDIO_DURATION_UNKNOWN -1.0f
+
+/* A freshly read duration, with "unknown" told apart from "not read yet". */
+static inline float SA_KnownDuration(float Duration) {
+  return Duration > 0 ? Duration : AUDIO_DURATION_UNKNOWN;
+}
+
+/* Capacity growth for library buffers: doubling while small, then 1.5x, so a library of a
+ * million tracks doesn't reserve room for another million it will likely never use. */
+static inline uint32_t SA_GrowCapacity(uint32_t Capacity) {
+  return Capacity < (1 << 16) ? Capacity * 2 : Capacity + Capacity / 2;
+}
+
 extern AudioData *Audio;
 extern bool PausedMusic;
 extern double AudioDuration, AudioPosition;
 extern int32_t AudioVolume, AudioCurrentIndex;
 extern uint32_t SA_TotalAudio; 
+extern uint32_t AudioFinishedEvent;
 
 void AudioRemove(uint32_t Index);
 void UpdateAudioPosition();
+void HandleAudioFinished();
 void InitializeAudio();
-int32_t AddAudio(char *Path, char *Category);
-int8_t PlayAudio(char *Path);
+void ReserveAudio(uint32_t Count);
+int32_t InsertAudio(const char *Path, const char *Title, const char *Artist, const char *Album, const char *Copyright, const char *Category);
+void MoveAudio(uint32_t Index, uint8_t Category);
+void RenameAudio(uint32_t Index, const char *Path);
+void ConfigureCrossfade(float Seconds, uint8_t Curve);
+void UpdateAudio(uint32_t Index, const char *Title, const char *Artist, const char *Album, const char *Copyright);
+int32_t RestoreAudio(const AudioData *Data);
+void SA_BeginAudioBatch();
+void SA_CommitAudioBatch();
+int32_t GetAudioIndex(const char *Path);
+int8_t PlayAudio(const char *Path);
 
 #endif
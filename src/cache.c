@@ -0,0 +1,431 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+#include "arena.h"
+#include "audio.h"
+#include "cache.h"
+#include "category.h"
+#include "content.h"
+#include "import.h"
+#include "order.h"
+
+#ifndef WINDOWS
+#define CACHE_PATH_MAX PATH_MAX
+#else
+#define CACHE_PATH_MAX MAX_PATH
+#endif
+
+typedef struct {
+  char Magic[4];
+  uint32_t Version;
+  uint32_t RecordCount;
+  uint32_t StringBytes;
+  uint32_t CategoryNames[SA_MAX_CATEGORIES];
+} CacheHeader;
+
+typedef struct {
+  int64_t MTime;
+  uint64_t Size;
+  uint64_t Hash;
+  uint32_t Path;
+  uint32_t Title;
+  uint32_t TagArtist;
+  uint32_t TagCopyright;
+  uint32_t TagAlbum;
+  float Duration;
+  uint8_t Category;
+  uint8_t Reserved[7];
+} CacheRecord;
+
+typedef struct {
+  int64_t MTime;
+  uint64_t Size;
+} CacheStamp;
+
+/* Old -> new string offset, for the compacted string table written on save */
+typedef struct {
+  uint32_t From, To;
+} CacheRemap;
+
+static CacheStamp *Stamps;
+static uint32_t StampCapacity;
+
+void SA_CacheResize(uint32_t Capacity) {
+  if (Capacity <= StampCapacity)
+    return;
+
+  CacheStamp *l_Stamps = realloc(Stamps, sizeof(CacheStamp) * Capacity);
+
+  if (!l_Stamps) {
+    SDL_Log("[FATAL]: Unable to realloc cache stamps.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  memset(&l_Stamps[StampCapacity], 0, sizeof(CacheStamp) * (Capacity - StampCapacity));
+
+  Stamps = l_Stamps;
+  StampCapacity = Capacity;
+}
+
+/* Safe to call from any thread. */
+bool SA_FileStamp(const char *Path, int64_t *MTime, uint64_t *Size) {
+  SDL_PathInfo Info;
+
+  if (!SDL_GetPathInfo(Path, &Info) || Info.type != SDL_PATHTYPE_FILE)
+    return false;
+
+  *MTime = Info.modify_time;
+  *Size = Info.size;
+  return true;
+}
+
+/* Whether Path is missing from a directory that is still there. A file whose directory is gone too
+ * may be on a drive that isn't mounted, so that alone doesn't tell it was deleted. */
+bool SA_FileGone(const char *Path) {
+  SDL_PathInfo Info;
+  char Directory[CACHE_PATH_MAX];
+  size_t Length = strlen(Path);
+
+  if (SDL_GetPathInfo(Path, &Info) || Length >= sizeof(Directory))
+    return false;
+
+  memcpy(Directory, Path, Length + 1);
+
+  while (Length > 0 && Directory[Length - 1] != '/' && Directory[Length - 1] != '\\')
+    Length--;
+
+  if (Length <= 1)
+    return false;
+
+  Directory[Length - 1] = '\0';
+  return SDL_GetPathInfo(Directory, &Info) && Info.type == SDL_PATHTYPE_DIRECTORY;
+}
+
+void SA_CacheStamp(uint32_t Index, int64_t MTime, uint64_t Size) {
+  SA_CacheResize(SA_TotalAudio);
+  Stamps[Index] = (CacheStamp){MTime, Size};
+}
+
+void SA_CacheGetStamp(uint32_t Index, int64_t *MTime, uint64_t *Size) {
+  *MTime = Index < StampCapacity ? Stamps[Index].MTime : 0;
+  *Size = Index < StampCapacity ? Stamps[Index].Size : 0;
+}
+
+/* Name inside the pref path, malloc'd. */
+char *SA_CachePath(const char *Name) {
+  char *PrefPath = SDL_GetPrefPath("Sonata", "SonataAudio");
+
+  if (!PrefPath) {
+    SDL_Log("Unable to get the pref path: %s", SDL_GetError());
+    return NULL;
+  }
+
+  size_t Length = strlen(PrefPath) + strlen(Name) + 1;
+  char *Path = malloc(Length);
+
+  if (!Path) {
+    SDL_Log("[FATAL]: Unable to allocate the cache path.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  snprintf(Path, Length, "%s%s", PrefPath, Name);
+  SDL_free(PrefPath);
+
+  return Path;
+}
+
+static bool ValidOffset(uint32_t Offset, const CacheHeader *Header) {
+  return Offset < Header->StringBytes;
+}
+
+/* Checks every offset before anything is restored, a damaged file is ignored as a whole. */
+static bool ValidCache(const uint8_t *Data, size_t Length) {
+  const CacheHeader *Header = (const CacheHeader *)Data;
+
+  if (Length < sizeof(CacheHeader) || memcmp(Header->Magic, CACHE_MAGIC, 4) != 0 || Header->Version != CACHE_VERSION)
+    return false;
+
+  if ((uint64_t)sizeof(CacheHeader) + (uint64_t)Header->RecordCount * sizeof(CacheRecord) + Header->StringBytes != Length)
+    return false;
+
+  const CacheRecord *Records = (const CacheRecord *)(Data + sizeof(CacheHeader));
+  const char *Strings = (const char *)(Records + Header->RecordCount);
+
+  if (Header->StringBytes == 0 || Strings[0] != '\0' || Strings[Header->StringBytes - 1] != '\0')
+    return false;
+
+  if (Header->CategoryNames[0] == 0)
+    return false;
+
+  for (uint8_t i = 0; i < SA_MAX_CATEGORIES; i++) {
+    if (!ValidOffset(Header->CategoryNames[i], Header))
+      return false;
+  }
+
+  for (uint32_t i = 0; i < Header->RecordCount; i++) {
+    const CacheRecord *Record = &Records[i];
+
+    if (Record->Path == 0 || !ValidOffset(Record->Path, Header) || !ValidOffset(Record->Title, Header) ||
+        !ValidOffset(Record->TagArtist, Header) || !ValidOffset(Record->TagCopyright, Header) ||
+        !ValidOffset(Record->TagAlbum, Header) || Record->Category >= SA_MAX_CATEGORIES ||
+        Header->CategoryNames[Record->Category] == 0)
+      return false;
+  }
+
+  return true;
+}
+
+static void RestoreCache(const uint8_t *Data) {
+  const CacheHeader *Header = (const CacheHeader *)Data;
+  const CacheRecord *Records = (const CacheRecord *)(Data + sizeof(CacheHeader));
+
+  SA_ArenaLoad((const char *)(Records + Header->RecordCount), Header->StringBytes);
+
+  for (uint8_t i = 0; i < SA_MAX_CATEGORIES; i++)
+    Categories[i].Name = Header->CategoryNames[i];
+
+  ReserveAudio(Header->RecordCount);
+  SA_BeginAudioBatch();
+
+  for (uint32_t i = 0; i < Header->RecordCount; i++) {
+    const CacheRecord *Record = &Records[i];
+    AudioData l_Audio = {
+      .Path = Record->Path, .Title = Record->Title, .TagArtist = Record->TagArtist,
+      .TagCopyright = Record->TagCopyright, .TagAlbum = Record->TagAlbum,
+      .Category = Record->Category, .Duration = Record->Duration
+    };
+
+    int32_t Index = RestoreAudio(&l_Audio);
+
+    if (Index == -1)
+      continue;
+
+    SA_CacheStamp(Index, Record->MTime, Record->Size);
+    SA_ContentSet(Index, Record->Hash);
+  }
+
+  SA_CommitAudioBatch();
+  SA_ImportValidateLibrary();
+}
+
+/* Must run before anything is added to the library. */
+void SA_LoadCache() {
+  char *Path = SA_CachePath(CACHE_FILE);
+
+  if (!Path)
+    return;
+
+  uint64_t Start = SDL_GetTicksNS();
+  bool Loaded = false;
+  size_t Length = 0;
+
+  #ifndef WINDOWS
+  int File = open(Path, O_RDONLY);
+  struct stat Stats;
+
+  if (File != -1 && fstat(File, &Stats) == 0 && Stats.st_size > 0) {
+    Length = Stats.st_size;
+    void *Data = mmap(NULL, Length, PROT_READ, MAP_PRIVATE, File, 0);
+
+    if (Data != MAP_FAILED) {
+      madvise(Data, Length, MADV_SEQUENTIAL);
+
+      if ((Loaded = ValidCache(Data, Length)))
+        RestoreCache(Data);
+
+      munmap(Data, Length);
+    }
+  }
+
+  if (File != -1)
+    close(File);
+  #else
+  HANDLE File = CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  LARGE_INTEGER FileSize;
+
+  if (File != INVALID_HANDLE_VALUE && GetFileSizeEx(File, &FileSize) && FileSize.QuadPart > 0) {
+    HANDLE Mapping = CreateFileMappingA(File, NULL, PAGE_READONLY, 0, 0, NULL);
+    Length = FileSize.QuadPart;
+
+    if (Mapping) {
+      void *Data = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+
+      if (Data) {
+        if ((Loaded = ValidCache(Data, Length)))
+          RestoreCache(Data);
+
+        UnmapViewOfFile(Data);
+      }
+
+      CloseHandle(Mapping);
+    }
+  }
+
+  if (File != INVALID_HANDLE_VALUE)
+    CloseHandle(File);
+  #endif
+
+  if (Loaded)
+    SDL_Log("Library cache loaded in %.2f ms.", (SDL_GetTicksNS() - Start) / 1e6);
+  else if (Length != 0)
+    SDL_Log("Ignoring a damaged or outdated library cache.");
+
+  free(Path);
+}
+
+static int CompareRemap(const void *Key, const void *Entry) {
+  uint32_t Offset = *(const uint32_t *)Key, From = ((const CacheRemap *)Entry)->From;
+  return Offset < From ? -1 : Offset > From;
+}
+
+static uint32_t Remap(const CacheRemap *Map, uint32_t Count, uint32_t Offset) {
+  if (Offset == 0)
+    return 0;
+
+  const CacheRemap *Entry = bsearch(&Offset, Map, Count, sizeof(CacheRemap), CompareRemap);
+  return Entry ? Entry->To : 0;
+}
+
+static void Mark(uint8_t *Marks, uint32_t Offset) {
+  Marks[Offset >> 3] |= 1 << (Offset & 7);
+}
+
+/* Strings of removed tracks are left behind in the arena, so only the ones still referenced are
+ * written, in arena order. */
+static char *CompactStrings(uint32_t *Length, CacheRemap **Map, uint32_t *MapCount) {
+  uint32_t Size = SA_ArenaSize();
+  uint8_t *Marks = calloc(Size / 8 + 1, 1);
+  char *Strings = malloc(Size);
+  uint32_t Count = SA_MAX_CATEGORIES;
+
+  if (!Marks || !Strings) {
+    SDL_Log("[FATAL]: Unable to allocate the cache string table.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (uint8_t i = 0; i < SA_MAX_CATEGORIES; i++)
+    Mark(Marks, Categories[i].Name);
+
+  for (uint32_t i = 0; i < SA_TotalAudio; i++) {
+    if (Audio[i].Path == 0)
+      continue;
+
+    Mark(Marks, Audio[i].Path);
+    Mark(Marks, Audio[i].Title);
+    Mark(Marks, Audio[i].TagArtist);
+    Mark(Marks, Audio[i].TagCopyright);
+    Mark(Marks, Audio[i].TagAlbum);
+    Count += 5;
+  }
+
+  *Map = malloc(sizeof(CacheRemap) * Count);
+
+  if (!*Map) {
+    SDL_Log("[FATAL]: Unable to allocate the cache remap table.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  Strings[0] = '\0';
+  *Length = 1;
+  *MapCount = 0;
+
+  for (uint32_t Offset = 1; Offset < Size;) {
+    uint32_t l_Length = strlen(StringArena + Offset) + 1;
+
+    if (Marks[Offset >> 3] & (1 << (Offset & 7))) {
+      (*Map)[(*MapCount)++] = (CacheRemap){Offset, *Length};
+      memcpy(Strings + *Length, StringArena + Offset, l_Length);
+      *Length += l_Length;
+    }
+
+    Offset += l_Length;
+  }
+
+  free(Marks);
+  return Strings;
+}
+
+/* Written to a temporary file first and renamed over the old one, so a crash never leaves a
+ * half-written cache behind. */
+void SA_SaveCache() {
+  char *Path = SA_CachePath(CACHE_FILE);
+  char *TempPath = SA_CachePath(CACHE_FILE ".tmp");
+
+  if (!Path || !TempPath) {
+    free(Path);
+    free(TempPath);
+    return;
+  }
+
+  uint64_t Start = SDL_GetTicksNS();
+  CacheHeader Header = {.Version = CACHE_VERSION};
+  CacheRemap *Map;
+  uint32_t MapCount;
+  char *Strings = CompactStrings(&Header.StringBytes, &Map, &MapCount);
+
+  memcpy(Header.Magic, CACHE_MAGIC, 4);
+
+  for (uint8_t i = 0; i < SA_MAX_CATEGORIES; i++) {
+    Header.CategoryNames[i] = Remap(Map, MapCount, Categories[i].Name);
+    Header.RecordCount += Categories[i].Count;
+  }
+
+  CacheRecord *Records = calloc(Header.RecordCount ? Header.RecordCount : 1, sizeof(CacheRecord));
+
+  if (!Records) {
+    SDL_Log("[FATAL]: Unable to allocate cache records.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  /* Layout order, so restoring by appending brings it back */
+  uint32_t Count = 0;
+
+  for (uint8_t i = 0; i < SA_MAX_CATEGORIES; i++) {
+    for (uint32_t Index = SA_OrderFirst(Categories[i].Root); Index != ORDER_NIL; Index = SA_OrderNext(Index)) {
+      Records[Count++] = (CacheRecord){
+        .MTime = Index < StampCapacity ? Stamps[Index].MTime : 0,
+        .Size = Index < StampCapacity ? Stamps[Index].Size : 0,
+        .Hash = SA_ContentGet(Index),
+        .Path = Remap(Map, MapCount, Audio[Index].Path),
+        .Title = Remap(Map, MapCount, Audio[Index].Title),
+        .TagArtist = Remap(Map, MapCount, Audio[Index].TagArtist),
+        .TagCopyright = Remap(Map, MapCount, Audio[Index].TagCopyright),
+        .TagAlbum = Remap(Map, MapCount, Audio[Index].TagAlbum),
+        .Duration = Audio[Index].Duration,
+        .Category = i
+      };
+    }
+  }
+
+  SDL_IOStream *IO = SDL_IOFromFile(TempPath, "wb");
+  bool Written = IO != NULL;
+
+  if (IO) {
+    Written = SDL_WriteIO(IO, &Header, sizeof(Header)) == sizeof(Header) &&
+              SDL_WriteIO(IO, Records, sizeof(CacheRecord) * Count) == sizeof(CacheRecord) * Count &&
+              SDL_WriteIO(IO, Strings, Header.StringBytes) == Header.StringBytes;
+    Written = SDL_CloseIO(IO) && Written;
+  }
+
+  if (Written && SDL_RenamePath(TempPath, Path))
+    SDL_Log("Library cache saved, %u tracks in %.2f ms.", Count, (SDL_GetTicksNS() - Start) / 1e6);
+  else
+    SDL_Log("Unable to save the library cache: %s", SDL_GetError());
+
+  free(Records);
+  free(Strings);
+  free(Map);
+  free(TempPath);
+  free(Path);
+}
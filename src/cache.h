@@ -0,0 +1,27 @@
+#ifndef __SACACHE__
+#define __SACACHE__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * The library is saved on exit to library.db in the user's pref path and mapped back on startup.
+ * The file holds a header, one fixed-width record per track in layout order, then the string table
+ * the records point into. Loading is a copy, no file is opened. Each record keeps the mtime and
+ * size its tags were read at, and its content hash; the import workers check them in the background
+ * and re-read only the tracks that changed.
+ */
+#define CACHE_MAGIC    "SADB"
+#define CACHE_VERSION  2
+#define CACHE_FILE     "library.db"
+
+void SA_CacheResize(uint32_t Capacity);
+bool SA_FileStamp(const char *Path, int64_t *MTime, uint64_t *Size);
+bool SA_FileGone(const char *Path);
+void SA_CacheStamp(uint32_t Index, int64_t MTime, uint64_t Size);
+void SA_CacheGetStamp(uint32_t Index, int64_t *MTime, uint64_t *Size);
+char *SA_CachePath(const char *Name);
+void SA_LoadCache();
+void SA_SaveCache();
+
+#endif
@@ -0,0 +1,75 @@
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "audio.h"
+#include "category.h"
+#include "order.h"
+
+CategoryData Categories[SA_MAX_CATEGORIES];
+
+void InitializeCategories() {
+  for (uint8_t i = 0; i < SA_MAX_CATEGORIES; i++)
+    Categories[i].Root = ORDER_NIL;
+
+  SA_CreateCategory("All");
+}
+
+int32_t SA_FindCategory(const char *Name) {
+  for (uint8_t i = 0; i < SA_MAX_CATEGORIES; i++) {
+    if (Categories[i].Name != 0 && strcmp(SA_String(Categories[i].Name), Name) == 0)
+      return i;
+  }
+
+  return -1;
+}
+
+int32_t SA_CreateCategory(const char *Name) {
+  int32_t Category = SA_FindCategory(Name);
+
+  if (Category != -1)
+    return Category;
+
+  for (uint8_t i = 0; i < SA_MAX_CATEGORIES; i++) {
+    if (Categories[i].Name != 0)
+      continue;
+
+    Categories[i].Name = SA_InternString(Name);
+    return i;
+  }
+
+  return -1;
+}
+
+void SA_CategoryAppend(uint8_t Category, uint32_t Index) {
+  CategoryData *l_Category = &Categories[Category];
+
+  Audio[Index].Category = Category;
+  l_Category->Root = SA_OrderInsert(l_Category->Root, Index, l_Category->Count);
+  l_Category->Count += 1;
+}
+
+void SA_CategoryRemove(uint8_t Category, uint32_t Index) {
+  CategoryData *l_Category = &Categories[Category];
+
+  l_Category->Root = SA_OrderErase(l_Category->Root, Index);
+  l_Category->Count -= 1;
+}
+
+/* Moves a member to Position, counted after it has been taken out of the list. */
+void SA_CategoryMove(uint8_t Category, uint32_t Index, uint32_t Position) {
+  CategoryData *l_Category = &Categories[Category];
+
+  l_Category->Root = SA_OrderErase(l_Category->Root, Index);
+  l_Category->Root = SA_OrderInsert(l_Category->Root, Index, Position < l_Category->Count ? Position : l_Category->Count - 1);
+}
+
+int32_t SA_CategoryAt(uint8_t Category, uint32_t Position) {
+  uint32_t Index = SA_OrderAt(Categories[Category].Root, Position);
+  return Index == ORDER_NIL ? -1 : (int32_t)Index;
+}
+
+uint32_t SA_CategoryPosition(uint32_t Index) {
+  return SA_OrderPosition(Index);
+}
@@ -0,0 +1,30 @@
+#ifndef __SACATEGORY__
+#define __SACATEGORY__
+
+#include <stdint.h>
+
+#define SA_MAX_CATEGORIES 32
+
+/*
+ * Categories are referred to by their index into Categories. Each one keeps its members in layout
+ * order as an order-statistic tree (see order.h), rooted at Root. Category 0 is "All".
+ */
+typedef struct {
+  uint32_t Name; /* Arena offset, 0 for an unused category */
+  
+  uint32_t Root;
+  uint32_t Count;
+} CategoryData;
+
+extern CategoryData Categories[SA_MAX_CATEGORIES];
+
+void InitializeCategories();
+int32_t SA_FindCategory(const char *Name);
+int32_t SA_CreateCategory(const char *Name);
+void SA_CategoryAppend(uint8_t Category, uint32_t Index);
+void SA_CategoryRemove(uint8_t Category, uint32_t Index);
+void SA_CategoryMove(uint8_t Category, uint32_t Index, uint32_t Position);
+int32_t SA_CategoryAt(uint8_t Category, uint32_t Position);
+uint32_t SA_CategoryPosition(uint32_t Index);
+
+#endif
@@ -0,0 +1,223 @@
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "content.h"
+
+/* xxHash64 primes */
+#define PRIME1 0x9E3779B185EBCA87ULL
+#define PRIME2 0xC2B2AE3D27D4EB4FULL
+#define PRIME3 0x165667B19E3779F9ULL
+#define PRIME4 0x85EBCA77C2B2AE63ULL
+#define PRIME5 0x27D4EB2F165667C5ULL
+
+/* Index -> hash, and hash -> index with linear probing. Several tracks may share a hash (duplicates
+ * already in the library are only flagged), so the table holds indices and removal looks for the
+ * exact one. Empty slots hold -1. */
+static uint64_t *Hashes;
+static uint32_t HashCapacity;
+static int32_t *Table;
+static uint32_t TableSize;
+
+static inline uint64_t RotateLeft(uint64_t Value, uint8_t Bits) {
+  return (Value << Bits) | (Value >> (64 - Bits));
+}
+
+static inline uint64_t Round(uint64_t Accumulator, uint64_t Input) {
+  return RotateLeft(Accumulator + Input * PRIME2, 31) * PRIME1;
+}
+
+static inline uint64_t Load64(const uint8_t *Data) {
+  uint64_t Value;
+  memcpy(&Value, Data, sizeof(Value));
+  return Value;
+}
+
+/* xxHash64's four-lane loop and finalizer over one block. Blocks are chained through Seed. */
+static uint64_t HashBlock(const uint8_t *Data, size_t Length, uint64_t Seed) {
+  const uint8_t *End = Data + Length;
+  uint64_t Hash;
+
+  if (Length >= 32) {
+    uint64_t Lanes[4] = {Seed + PRIME1 + PRIME2, Seed + PRIME2, Seed, Seed - PRIME1};
+
+    for (; Data + 32 <= End; Data += 32) {
+      Lanes[0] = Round(Lanes[0], Load64(Data));
+      Lanes[1] = Round(Lanes[1], Load64(Data + 8));
+      Lanes[2] = Round(Lanes[2], Load64(Data + 16));
+      Lanes[3] = Round(Lanes[3], Load64(Data + 24));
+    }
+
+    Hash = RotateLeft(Lanes[0], 1) + RotateLeft(Lanes[1], 7) + RotateLeft(Lanes[2], 12) + RotateLeft(Lanes[3], 18);
+  } else {
+    Hash = Seed + PRIME5;
+  }
+
+  Hash += Length;
+
+  for (; Data + 8 <= End; Data += 8)
+    Hash = RotateLeft(Hash ^ Round(0, Load64(Data)), 27) * PRIME1 + PRIME4;
+
+  for (; Data < End; Data++)
+    Hash = RotateLeft(Hash ^ (*Data * PRIME5), 11) * PRIME1;
+
+  Hash ^= Hash >> 33;
+  Hash *= PRIME2;
+  Hash ^= Hash >> 29;
+  Hash *= PRIME3;
+  Hash ^= Hash >> 32;
+
+  return Hash;
+}
+
+/* Safe to call from any thread. Small files are hashed whole, larger ones by their samples. */
+bool SA_ContentHash(const char *Path, uint64_t *Hash) {
+  SDL_IOStream *IO = SDL_IOFromFile(Path, "rb");
+
+  if (!IO)
+    return false;
+
+  uint8_t *Buffer = malloc(CONTENT_SAMPLE);
+  Sint64 Size = SDL_GetIOSize(IO);
+  bool Hashed = Buffer != NULL && Size >= 0;
+  uint64_t Result = Size;
+
+  if (Hashed && Size <= CONTENT_FULL) {
+    size_t Read;
+
+    while ((Read = SDL_ReadIO(IO, Buffer, CONTENT_SAMPLE)) > 0)
+      Result = HashBlock(Buffer, Read, Result);
+
+    Hashed = SDL_GetIOStatus(IO) == SDL_IO_STATUS_EOF;
+  } else if (Hashed) {
+    Sint64 Offsets[3] = {0, (Size - CONTENT_SAMPLE) / 2, Size - CONTENT_SAMPLE};
+
+    for (uint8_t i = 0; i < 3 && Hashed; i++) {
+      Hashed = SDL_SeekIO(IO, Offsets[i], SDL_IO_SEEK_SET) >= 0 && SDL_ReadIO(IO, Buffer, CONTENT_SAMPLE) == CONTENT_SAMPLE;
+      Result = HashBlock(Buffer, CONTENT_SAMPLE, Result);
+    }
+  }
+
+  free(Buffer);
+  SDL_CloseIO(IO);
+
+  /* 0 is kept for "not hashed" */
+  *Hash = !Hashed ? 0 : Result ? Result : 1;
+  return Hashed;
+}
+
+static void TableInsert(uint32_t Index) {
+  uint32_t Mask = TableSize - 1;
+  uint32_t Slot = (uint32_t)Hashes[Index] & Mask;
+
+  while (Table[Slot] != -1)
+    Slot = (Slot + 1) & Mask;
+
+  Table[Slot] = Index;
+}
+
+static void TableRemove(uint32_t Index) {
+  uint32_t Mask = TableSize - 1;
+  uint32_t Slot = (uint32_t)Hashes[Index] & Mask;
+
+  while (Table[Slot] != (int32_t)Index) {
+    if (Table[Slot] == -1)
+      return;
+
+    Slot = (Slot + 1) & Mask;
+  }
+
+  /* Backward shift deletion, as for the path table */
+  uint32_t Next = (Slot + 1) & Mask;
+
+  while (Table[Next] != -1) {
+    uint32_t Home = (uint32_t)Hashes[Table[Next]] & Mask;
+
+    if (((Next - Home) & Mask) >= ((Next - Slot) & Mask)) {
+      Table[Slot] = Table[Next];
+      Slot = Next;
+    }
+
+    Next = (Next + 1) & Mask;
+  }
+
+  Table[Slot] = -1;
+}
+
+/* Both tables follow the Audio buffer; the hash table stays a power of two at least twice its size. */
+void SA_ContentResize(uint32_t Capacity) {
+  if (Capacity <= HashCapacity)
+    return;
+
+  uint64_t *l_Hashes = realloc(Hashes, sizeof(uint64_t) * Capacity);
+
+  if (!l_Hashes) {
+    SDL_Log("[FATAL]: Unable to realloc content hashes.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  memset(&l_Hashes[HashCapacity], 0, sizeof(uint64_t) * (Capacity - HashCapacity));
+
+  Hashes = l_Hashes;
+  HashCapacity = Capacity;
+
+  uint32_t Size = TableSize ? TableSize : 4;
+
+  while (Size < Capacity * 2)
+    Size *= 2;
+
+  if (Size == TableSize)
+    return;
+
+  int32_t *l_Table = malloc(sizeof(int32_t) * Size);
+
+  if (!l_Table) {
+    SDL_Log("[FATAL]: Unable to allocate the content hash table.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  free(Table);
+  memset(l_Table, 0xff, sizeof(int32_t) * Size);
+
+  Table = l_Table;
+  TableSize = Size;
+
+  for (uint32_t i = 0; i < HashCapacity; i++)
+    if (Hashes[i] != 0)
+      TableInsert(i);
+}
+
+/* Hash 0 takes the track out of the table, which AudioRemove does for a vacated slot. */
+void SA_ContentSet(uint32_t Index, uint64_t Hash) {
+  SA_ContentResize(Index + 1);
+
+  if (Hashes[Index] == Hash)
+    return;
+
+  if (Hashes[Index] != 0)
+    TableRemove(Index);
+
+  Hashes[Index] = Hash;
+
+  if (Hash != 0)
+    TableInsert(Index);
+}
+
+uint64_t SA_ContentGet(uint32_t Index) {
+  return Index < HashCapacity ? Hashes[Index] : 0;
+}
+
+/* A track other than Except with this content, or -1. */
+int32_t SA_ContentFind(uint64_t Hash, int32_t Except) {
+  if (Hash == 0 || TableSize == 0)
+    return -1;
+
+  uint32_t Mask = TableSize - 1;
+
+  for (uint32_t Slot = (uint32_t)Hash & Mask; Table[Slot] != -1; Slot = (Slot + 1) & Mask) {
+    if (Table[Slot] != Except && Hashes[Table[Slot]] == Hash)
+      return Table[Slot];
+  }
+
+  return -1;
+}
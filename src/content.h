@@ -0,0 +1,23 @@
+#ifndef __SACONTENT__
+#define __SACONTENT__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Content hashes, to catch the same file reached through two paths (two mount points, a copy in
+ * another folder). A file is hashed with its size and, past CONTENT_FULL bytes, three samples of
+ * CONTENT_SAMPLE bytes from its start, middle and end, so a hash costs three reads at most. The
+ * import workers hash files as they read their tags; the library keeps Hash -> index in an open
+ * addressed table. Hash 0 means not hashed yet.
+ */
+#define CONTENT_SAMPLE (64 * 1024)
+#define CONTENT_FULL   (3 * CONTENT_SAMPLE)
+
+void SA_ContentResize(uint32_t Capacity);
+bool SA_ContentHash(const char *Path, uint64_t *Hash);
+void SA_ContentSet(uint32_t Index, uint64_t Hash);
+uint64_t SA_ContentGet(uint32_t Index);
+int32_t SA_ContentFind(uint64_t Hash, int32_t Except);
+
+#endif
@@ -0,0 +1,326 @@
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef WINDOWS
+#include <SDL3_mixer/SDL_mixer.h>
+#else
+#include <SDL3/SDL_mixer.h>
+#endif
+
+#include "crossfade.h"
+
+enum CrossfadePhase {
+  CROSSFADE_IDLE,
+  CROSSFADE_MIXING,  /* The outgoing track fading out, the head of the next one fading in over it */
+  CROSSFADE_FADE_IN  /* Handed over before the fade was done, the incoming decoder keeps ramping up */
+};
+
+typedef struct {
+  float *Samples;
+  uint32_t Frames;
+  uint32_t Index;
+  float DecodeMS;
+} CrossfadeHead;
+
+float CrossfadeSeconds;
+uint8_t CrossfadeCurve = CROSSFADE_EQUAL_POWER;
+
+static bool Enabled;
+static int Frequency, Channels;
+
+/* Shared with the mixer and preload threads, only changed under Mix_LockAudio. Ready is the head
+ * waiting for its turn and Active the one being mixed. The decoder fills whichever buffer isn't
+ * Active, so the mixer never reads one that is being written. */
+static CrossfadeHead Heads[2];
+static int8_t Ready = -1, Active = -1;
+static uint32_t Capacity; /* Frames per head, 0 until crossfades are first turned on */
+static uint8_t Phase, Curve;
+static bool Held;
+static float Gain = 1.0f; /* The music volume, the head doesn't go through SDL_mixer's */
+static uint32_t Cursor, Progress, Length; /* Head read position, fade progress and length, in frames */
+
+/* Mixer thread cost of the current transition, in performance counter ticks */
+static uint64_t Callbacks, Ticks, MaxTicks;
+
+static void Gains(uint32_t At, float *Out, float *In) {
+  float T = (float)At / Length;
+
+  if (Curve == CROSSFADE_LINEAR) {
+    *Out = 1.0f - T;
+    *In = T;
+  } else {
+    *Out = SDL_cosf(T * SDL_PI_F * 0.5f);
+    *In = SDL_sinf(T * SDL_PI_F * 0.5f);
+  }
+}
+
+/* Called under the lock. Stops mixing but keeps the head around for another try, unless a newer
+ * one was decoded in the meantime. */
+static void Rewind() {
+  if (Phase == CROSSFADE_MIXING && Ready == -1)
+    Ready = Active;
+
+  Active = -1;
+  Phase = CROSSFADE_IDLE;
+  Cursor = Progress = 0;
+}
+
+void InitializeCrossfade(int l_Frequency, bool Float, int l_Channels) {
+  Frequency = l_Frequency;
+  Channels = l_Channels;
+  Enabled = Float;
+
+  if (!Enabled)
+    SDL_Log("Crossfades are unavailable, the audio device didn't accept float samples.");
+}
+
+void ShutdownCrossfade() {
+  Mix_LockAudio();
+  Rewind();
+  Ready = -1;
+  Capacity = 0;
+  Mix_UnlockAudio();
+
+  for (uint8_t i = 0; i < 2; i++) {
+    free(Heads[i].Samples);
+    Heads[i].Samples = NULL;
+  }
+}
+
+/* Seconds of 0 turns crossfades off. The heads are allocated at their largest the first time they
+ * are turned on, so changing the length never reallocates under the other threads. */
+void SA_CrossfadeConfigure(float Seconds, uint8_t l_Curve) {
+  if (!Enabled)
+    return;
+
+  if (Seconds > 0 && Capacity == 0) {
+    uint32_t Frames = (CROSSFADE_MAX_SECONDS + CROSSFADE_MARGIN) * Frequency;
+
+    for (uint8_t i = 0; i < 2; i++) {
+      Heads[i].Samples = malloc(sizeof(float) * Frames * Channels);
+
+      if (!Heads[i].Samples) {
+        SDL_Log("[FATAL]: Unable to allocate the crossfade buffers.\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+
+    Mix_LockAudio();
+    Capacity = Frames;
+    Mix_UnlockAudio();
+  }
+
+  CrossfadeSeconds = Seconds < CROSSFADE_MAX_SECONDS ? Seconds : CROSSFADE_MAX_SECONDS;
+  CrossfadeCurve = l_Curve;
+
+  if (CrossfadeSeconds <= 0)
+    SA_CrossfadeCancel();
+}
+
+/* Runs on the preload thread. Decodes the start of Index into the free head. SDL_mixer only decodes
+ * whole files, so the rest is thrown away; the copy is made outside the lock. */
+void SA_CrossfadeDecode(uint32_t Index, const char *Path) {
+  Mix_LockAudio();
+  bool Decoded = (Ready != -1 && Heads[Ready].Index == Index) || (Active != -1 && Heads[Active].Index == Index);
+  bool Off = Capacity == 0;
+  Mix_UnlockAudio();
+
+  if (Decoded || Off)
+    return;
+
+  uint64_t Start = SDL_GetPerformanceCounter();
+  Mix_Chunk *Chunk = Mix_LoadWAV(Path);
+
+  if (!Chunk) {
+    SDL_Log("Unable to decode the start of \"%s\" for a crossfade: %s", Path, SDL_GetError());
+    return;
+  }
+
+  Mix_LockAudio();
+  int8_t Target = Active == 0 ? 1 : 0;
+
+  if (Ready == Target)
+    Ready = -1;
+
+  uint32_t Frames = Chunk->alen / (sizeof(float) * Channels);
+
+  if (Frames > Capacity)
+    Frames = Capacity;
+  Mix_UnlockAudio();
+
+  memcpy(Heads[Target].Samples, Chunk->abuf, sizeof(float) * Frames * Channels);
+  Mix_FreeChunk(Chunk);
+
+  Mix_LockAudio();
+  Heads[Target].Frames = Frames;
+  Heads[Target].Index = Index;
+  Heads[Target].DecodeMS = (SDL_GetPerformanceCounter() - Start) * 1000.0 / SDL_GetPerformanceFrequency();
+  Ready = Frames > 0 ? Target : -1;
+  Mix_UnlockAudio();
+}
+
+/* Called every frame. Starts the fade once the current track is within the fade length of its end
+ * and the head of Next is ready, and drops it again if the track was seeked back or Next changed. */
+void SA_CrossfadeUpdate(int32_t Next, double Position, double Duration, bool Paused, int Volume) {
+  if (!Enabled || Capacity == 0)
+    return;
+
+  double Remaining = Duration - Position;
+
+  Mix_LockAudio();
+  Held = Paused;
+  Gain = (float)Volume / MIX_MAX_VOLUME;
+
+  if (Phase != CROSSFADE_MIXING) {
+    bool Due = Duration > 0 && Remaining > 0 && Remaining <= CrossfadeSeconds;
+
+    if (Due && !Paused && Ready != -1 && Heads[Ready].Index == (uint32_t)Next) {
+      Active = Ready;
+      Ready = -1;
+
+      /* The fade ends with the track; a head too short for that shortens it */
+      Length = (uint32_t)(Remaining * Frequency);
+      Length = Length < Heads[Active].Frames ? Length : Heads[Active].Frames;
+      Length = Length > 0 ? Length : 1;
+
+      Cursor = Progress = 0;
+      Curve = CrossfadeCurve;
+      Callbacks = Ticks = MaxTicks = 0;
+      Phase = CROSSFADE_MIXING;
+    }
+  } else if (Next == -1 || Heads[Active].Index != (uint32_t)Next || Remaining > (double)(Length - Progress) / Frequency + 1.0) {
+    Rewind();
+  }
+
+  Mix_UnlockAudio();
+}
+
+/* The track being faded in, or -1. */
+int32_t SA_CrossfadeIncoming() {
+  int32_t Index = -1;
+
+  Mix_LockAudio();
+
+  if (Phase == CROSSFADE_MIXING)
+    Index = Heads[Active].Index;
+
+  Mix_UnlockAudio();
+  return Index;
+}
+
+/* Hands the fade over to the incoming track's decoder, returning the position it should start from.
+ * Call under Mix_LockAudio together with starting it, so the head doesn't move on in between. */
+double SA_CrossfadeHandover() {
+  double Offset = 0;
+  uint64_t l_Callbacks = 0, l_Ticks = 0, l_MaxTicks = 0;
+  float DecodeMS = 0;
+
+  Mix_LockAudio();
+
+  if (Phase == CROSSFADE_MIXING) {
+    Offset = (double)Cursor / Frequency;
+    DecodeMS = Heads[Active].DecodeMS;
+    l_Callbacks = Callbacks;
+    l_Ticks = Ticks;
+    l_MaxTicks = MaxTicks;
+
+    Active = -1;
+    Phase = Progress < Length ? CROSSFADE_FADE_IN : CROSSFADE_IDLE;
+  }
+
+  Mix_UnlockAudio();
+
+  #ifndef NDEBUG
+  if (l_Callbacks > 0) {
+    double Microseconds = 1000000.0 / SDL_GetPerformanceFrequency();
+
+    SDL_Log("[STATS]: Crossfade over %llu callbacks, %.2f us mean, %.2f us max; head decoded in %.1f ms, handed over at %.3f s.",
+            (unsigned long long)l_Callbacks, l_Ticks * Microseconds / l_Callbacks, l_MaxTicks * Microseconds, DecodeMS, Offset);
+  }
+  #else
+  (void)l_Callbacks;
+  (void)l_Ticks;
+  (void)l_MaxTicks;
+  (void)DecodeMS;
+  #endif
+
+  return Offset;
+}
+
+void SA_CrossfadeCancel() {
+  Mix_LockAudio();
+  Rewind();
+  Mix_UnlockAudio();
+}
+
+/* Drops anything decoded for a track that left the library, its slot may be reused. */
+void SA_CrossfadeForget(uint32_t Index) {
+  Mix_LockAudio();
+
+  if (Phase == CROSSFADE_MIXING && Heads[Active].Index == Index) {
+    Active = -1;
+    Phase = CROSSFADE_IDLE;
+  }
+
+  if (Ready != -1 && Heads[Ready].Index == Index)
+    Ready = -1;
+
+  Mix_UnlockAudio();
+}
+
+/* Runs on the mixer thread, from the post-mix callback, on the final interleaved float stream. */
+void SA_CrossfadeMix(float *Samples, uint32_t Frames) {
+  if (Phase == CROSSFADE_IDLE || Held || Frames == 0)
+    return;
+
+  uint64_t Start = SDL_GetPerformanceCounter();
+  float OutFrom, InFrom, OutTo, InTo;
+
+  Gains(Progress, &OutFrom, &InFrom);
+  Progress = Length - Progress > Frames ? Progress + Frames : Length;
+  Gains(Progress, &OutTo, &InTo);
+
+  float OutStep = (OutTo - OutFrom) / Frames, InStep = (InTo - InFrom) / Frames;
+
+  if (Phase == CROSSFADE_MIXING) {
+    const CrossfadeHead *Head = &Heads[Active];
+    const float *Source = Head->Samples + (size_t)Cursor * Channels;
+    uint32_t Mixed = Head->Frames - Cursor < Frames ? Head->Frames - Cursor : Frames;
+    uint32_t i = 0;
+
+    for (; i < Mixed; i++) {
+      float Out = OutFrom + OutStep * i, In = (InFrom + InStep * i) * Gain;
+
+      for (int c = 0; c < Channels; c++)
+        Samples[i * Channels + c] = Samples[i * Channels + c] * Out + Source[i * Channels + c] * In;
+    }
+
+    /* Ran out of head, only happens if the handover is late by more than the margin */
+    for (; i < Frames; i++) {
+      float Out = OutFrom + OutStep * i;
+
+      for (int c = 0; c < Channels; c++)
+        Samples[i * Channels + c] *= Out;
+    }
+
+    Cursor += Mixed;
+  } else {
+    /* The incoming track already plays at the music volume */
+    for (uint32_t i = 0; i < Frames; i++) {
+      float In = InFrom + InStep * i;
+
+      for (int c = 0; c < Channels; c++)
+        Samples[i * Channels + c] *= In;
+    }
+
+    if (Progress >= Length)
+      Phase = CROSSFADE_IDLE;
+  }
+
+  uint64_t Elapsed = SDL_GetPerformanceCounter() - Start;
+
+  Callbacks++;
+  Ticks += Elapsed;
+  MaxTicks = Elapsed > MaxTicks ? Elapsed : MaxTicks;
+}
@@ -0,0 +1,41 @@
+#ifndef __SACROSSFADE__
+#define __SACROSSFADE__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Crossfades from one queue entry into the next. While a track plays, the preload thread decodes
+ * the first seconds of the one after it into a buffer. Near the end of the current track the
+ * post-mix callback fades it out and mixes that buffer in over it. Once the current track has run
+ * out, the next one's decoder picks up from wherever the buffer had got to. On the mixer thread this
+ * costs one multiply-add per sample: gains are worked out once per callback and interpolated across
+ * it. Only float output is supported; with any other format crossfades stay off.
+ */
+#define CROSSFADE_MAX_SECONDS 12
+#define CROSSFADE_MARGIN      1    /* Seconds of head decoded past the fade, to cover the handover */
+
+/* SDL_mixer can only decode a whole file, so only tracks of a known length up to this many seconds
+ * are decoded ahead. That caps the memory briefly held to about 115 MB at 48 kHz stereo. */
+#define CROSSFADE_DECODE_LIMIT 300
+
+enum CrossfadeCurve {
+  CROSSFADE_EQUAL_POWER,
+  CROSSFADE_LINEAR
+};
+
+extern float CrossfadeSeconds;
+extern uint8_t CrossfadeCurve;
+
+void InitializeCrossfade(int Frequency, bool Float, int Channels);
+void ShutdownCrossfade();
+void SA_CrossfadeConfigure(float Seconds, uint8_t Curve);
+void SA_CrossfadeDecode(uint32_t Index, const char *Path);
+void SA_CrossfadeUpdate(int32_t Next, double Position, double Duration, bool Paused, int Volume);
+int32_t SA_CrossfadeIncoming();
+double SA_CrossfadeHandover();
+void SA_CrossfadeCancel();
+void SA_CrossfadeForget(uint32_t Index);
+void SA_CrossfadeMix(float *Samples, uint32_t Frames);
+
+#endif
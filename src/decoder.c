@@ -0,0 +1,85 @@
+#include <SDL3/SDL.h>
+
+#include "cache.h"
+#include "decoder.h"
+
+typedef struct {
+  Mix_Music *Music;
+  uint32_t Index;
+  uint64_t Cost;    /* File size, as a stand-in for what the decoder holds */
+  uint64_t LastUse;
+} DecoderEntry;
+
+/* Few enough entries that a linear scan beats keeping a list in order */
+static DecoderEntry Entries[DECODER_CACHE_HANDLES];
+static uint32_t EntryCount;
+static uint64_t Bytes, Clock;
+
+static int32_t Find(uint32_t Index) {
+  for (uint32_t i = 0; i < EntryCount; i++) {
+    if (Entries[i].Index == Index)
+      return i;
+  }
+
+  return -1;
+}
+
+static Mix_Music *Remove(uint32_t Slot) {
+  Mix_Music *Music = Entries[Slot].Music;
+
+  Bytes -= Entries[Slot].Cost;
+  Entries[Slot] = Entries[--EntryCount];
+
+  return Music;
+}
+
+/* The cached handle for Index, now owned by the caller, or NULL. */
+Mix_Music *SA_DecoderTake(uint32_t Index) {
+  int32_t Slot = Find(Index);
+  return Slot == -1 ? NULL : Remove(Slot);
+}
+
+bool SA_DecoderContains(uint32_t Index) {
+  return Find(Index) != -1;
+}
+
+/* Hands the handle of a track that stopped playing to the cache, which closes it when evicted. */
+void SA_DecoderPut(uint32_t Index, Mix_Music *Music) {
+  int64_t MTime;
+  uint64_t Cost;
+
+  SA_CacheGetStamp(Index, &MTime, &Cost);
+  SA_DecoderForget(Index);
+
+  if (Cost > DECODER_CACHE_BYTES) {
+    Mix_FreeMusic(Music);
+    return;
+  }
+
+  while (EntryCount > 0 && (EntryCount == DECODER_CACHE_HANDLES || Bytes + Cost > DECODER_CACHE_BYTES)) {
+    uint32_t Oldest = 0;
+
+    for (uint32_t i = 1; i < EntryCount; i++) {
+      if (Entries[i].LastUse < Entries[Oldest].LastUse)
+        Oldest = i;
+    }
+
+    Mix_FreeMusic(Remove(Oldest));
+  }
+
+  Entries[EntryCount++] = (DecoderEntry){Music, Index, Cost, ++Clock};
+  Bytes += Cost;
+}
+
+/* Closes the handle of a track that was removed or changed on disk. */
+void SA_DecoderForget(uint32_t Index) {
+  int32_t Slot = Find(Index);
+
+  if (Slot != -1)
+    Mix_FreeMusic(Remove(Slot));
+}
+
+void SA_DecoderClear() {
+  while (EntryCount > 0)
+    Mix_FreeMusic(Remove(EntryCount - 1));
+}
@@ -0,0 +1,29 @@
+#ifndef __SADECODER__
+#define __SADECODER__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef WINDOWS
+#include <SDL3_mixer/SDL_mixer.h>
+#else
+#include <SDL3/SDL_mixer.h>
+#endif
+
+/*
+ * Opened Mix_Music handles of recently played tracks, keyed by library index, so replaying or going
+ * back to one starts without touching the filesystem. The playing track's handle is owned by
+ * audio.c and goes back in here when another one starts. The least recently played handle is
+ * closed once there are DECODER_CACHE_HANDLES of them or their files add up to more than
+ * DECODER_CACHE_BYTES (some decoders hold the whole file). Main thread only.
+ */
+#define DECODER_CACHE_HANDLES 8
+#define DECODER_CACHE_BYTES   (128 * 1024 * 1024ULL)
+
+Mix_Music *SA_DecoderTake(uint32_t Index);
+bool SA_DecoderContains(uint32_t Index);
+void SA_DecoderPut(uint32_t Index, Mix_Music *Music);
+void SA_DecoderForget(uint32_t Index);
+void SA_DecoderClear();
+
+#endif
@@ -2,9 +2,19 @@
 #include <SDL3/SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "discord.h"
+#include "search.h"
 #include "audio.h"
+#include "cache.h"
+#include "decoder.h"
+#include "import.h"
+#include "playlist.h"
+#include "preload.h"
+#include "crossfade.h"
+#include "equalizer.h"
+#include "watch.h"
 #include "render.h"
 #include "microui.h"
 #include "map.h"
@@ -13,12 +23,61 @@
 bool Running = true;
 unsigned int FPS = 240, DefaultFPS = 240;
 
+static inline double ElapsedMS(uint64_t Start) {
+  return (SDL_GetPerformanceCounter() - Start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+#ifndef NDEBUG
+static bool StressMode = false;
+
+/*
+ * Debug builds only. `SonataAudio --stress <count>` fills the library with synthetic tracks (no file
+ * is opened) and logs how long the import, a full playlist refresh and a few searches take. Frame
+ * times are logged afterwards, so scrolling through the list can be checked as well.
+ */
+static void StressLibrary(uint32_t Count) {
+  char Path[64], Title[32], Artist[32], Album[32];
+  uint64_t Start = SDL_GetPerformanceCounter();
+
+  for (uint32_t i = 0; i < Count; i++) {
+    snprintf(Path, sizeof(Path), "/stress/%u.ogg", i);
+    snprintf(Title, sizeof(Title), "Track %u", i);
+    snprintf(Artist, sizeof(Artist), "Artist %u", i % 5000);
+    snprintf(Album, sizeof(Album), "Album %u", i % 40000);
+
+    InsertAudio(Path, Title, Artist, Album, NULL, NULL);
+  }
+
+  SDL_Log("[STRESS]: Imported %u tracks in %.1f ms.", Count, ElapsedMS(Start));
+
+  Start = SDL_GetPerformanceCounter();
+  RefreshPlaylist();
+  SDL_Log("[STRESS]: Playlist refresh took %.2f ms.", ElapsedMS(Start));
+
+  const char *Queries[] = {"track 12345", "artist 42", "album 777", "zzz"};
+  uint32_t *Results = malloc(sizeof(uint32_t) * SA_TotalAudio);
+
+  for (uint8_t i = 0; i < SDL_arraysize(Queries); i++) {
+    Start = SDL_GetPerformanceCounter();
+    int32_t Found = SA_SearchQuery(Queries[i], 0, Results);
+    SDL_Log("[STRESS]: Search \"%s\" found %d in %.3f ms.", Queries[i], Found, ElapsedMS(Start));
+  }
+
+  free(Results);
+  StressMode = true;
+}
+#endif
+
 int main(int argc, char **argv) {
   SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO | SDL_INIT_EVENTS);
   r_init();
   InitializeAudio();
   InitializeGUI();
+  InitializeImport();
+  InitializePreload();
   InitializeRPC();
+  SA_LoadCache();
+  InitializeWatch();
 
   mu_Context *Context = malloc(sizeof(mu_Context));
   mu_init(Context);
@@ -26,21 +85,46 @@ int main(int argc, char **argv) {
   Context->text_width = TextWidth;
   Context->text_height = TextHeight;
 
-  if (argc > 1) {
-    AddAudio(argv[1], NULL);
-    PlayAudio(argv[1]);
+  #ifndef NDEBUG
+  if (argc > 2 && strcmp(argv[1], "--stress") == 0) {
+    StressLibrary(strtoul(argv[2], NULL, 10));
+    argc = 1;
+  } else if (argc > 1 && strcmp(argv[1], "--bench-eq") == 0) {
+    SA_EqualizerBenchmark();
+    argc = 1;
+  }
+  #endif
 
-    for (int i = 2; i < argc; i++)
-      AddAudio(argv[i], NULL);
+  if (argc > 1) {
+    bool Played = false;
+
+    /* The first file plays, whether the cache already had it or it still has to be imported */
+    for (int i = 1; i < argc; i++) {
+      if (SA_IsPlaylist(argv[i])) {
+        SA_PlaylistImport(argv[i]);
+      } else if (!Played) {
+        SA_ImportPlay(argv[i], 0);
+        Played = true;
+      } else if (GetAudioIndex(argv[i]) == -1) {
+        SA_ImportFile(argv[i], 0);
+      }
+    }
   }
 
   while (Running) {
     uint64_t Start = SDL_GetPerformanceCounter();
 
     UpdateAudioPosition();
+    SA_WatchPoll();
+    SA_ImportPoll();
     SDL_Event Event;
 
     while(SDL_PollEvent(&Event)) {
+      if (Event.type == AudioFinishedEvent) {
+        HandleAudioFinished();
+        continue;
+      }
+
       switch(Event.type) {
         case SDL_EVENT_QUIT:
           Running = false;
@@ -105,14 +189,45 @@ int main(int argc, char **argv) {
     }
 
     r_present();
-    
-    float Elapsed = (SDL_GetPerformanceCounter() - Start) / (float)SDL_GetPerformanceFrequency();
 
-    if (Elapsed > 0 && ((1000 / FPS) - Elapsed) > 0)
-      SDL_Delay((1000 / FPS) - Elapsed);
+    #ifndef NDEBUG
+    if (StressMode) {
+      static double FrameTotal = 0;
+      static uint32_t Frames = 0;
+
+      FrameTotal += ElapsedMS(Start);
+
+      if (++Frames == 240) {
+        SDL_Log("[STRESS]: Average frame time %.2f ms.", FrameTotal / Frames);
+        FrameTotal = 0;
+        Frames = 0;
+      }
+    }
+    #endif
+    
+    /* Waiting on the event queue rather than sleeping, so input and the end of a track are handled
+     * as soon as they come in. With the window in the background and nothing playing or importing,
+     * the loop only wakes up once a second. */
+    bool Idle = FPS != DefaultFPS && AudioCurrentIndex == -1 && SA_ImportIdle();
+    double Remaining = (Idle ? 1000.0 : 1000.0 / FPS) - ElapsedMS(Start);
+
+    if (Remaining > 0)
+      SDL_WaitEventTimeout(NULL, (int32_t)Remaining);
   }
 
   free(Context);
+  ShutdownWatch();
+  ShutdownImport();
+  ShutdownPreload();
+  ShutdownCrossfade();
+  SA_DecoderClear();
+
+  #ifndef NDEBUG
+  /* Synthetic tracks don't belong in the cache */
+  if (!StressMode)
+  #endif
+  SA_SaveCache();
+
   SDL_Quit();
   ShutdownRPC();
 
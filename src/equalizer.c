@@ -0,0 +1,350 @@
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+
+#define EQUALIZER_X86
+#define EQUALIZER_TARGET(Target) __attribute__((target(Target)))
+#endif
+
+#include "equalizer.h"
+
+#define LANES (EQUALIZER_BANDS * 2) /* Band b's left and right channel are lanes 2b and 2b + 1 */
+#define FRESH 4                     /* Set on the middle set's index when the mixer hasn't taken it yet */
+
+typedef struct {
+  float B0[LANES], B1[LANES], B2[LANES], A1[LANES], A2[LANES]; /* A1 and A2 negated, so every term adds */
+  bool Flat[EQUALIZER_BANDS];
+  uint8_t Count; /* Bands up to the last one that isn't flat; flat bands before it pass through */
+} EqualizerCoefficients;
+
+/* Transposed direct form II state. Y holds each lane's last output, which the skewed kernels feed
+ * into the next band on the following frame. */
+typedef struct {
+  float S1[LANES], S2[LANES], Y[LANES];
+  float Scalar[EQUALIZER_BANDS][EQUALIZER_MAX_CHANNELS][2];
+  bool Flat[EQUALIZER_BANDS]; /* As of the last run */
+  uint8_t Count;
+  int Channels;
+} EqualizerState;
+
+static const uint8_t KernelWidth[] = {1, 2, 4}; /* Bands per register */
+static const char *KernelName[] = {"scalar", "SSE2", "AVX2"};
+
+EqualizerBand EqualizerBands[EQUALIZER_BANDS] = {
+  {EQUALIZER_LOW_SHELF, 60, 0, 0.7f},
+  {EQUALIZER_PEAK, 150, 0, 1.0f},
+  {EQUALIZER_PEAK, 400, 0, 1.0f},
+  {EQUALIZER_PEAK, 1000, 0, 1.0f},
+  {EQUALIZER_PEAK, 2400, 0, 1.0f},
+  {EQUALIZER_PEAK, 6000, 0, 1.0f},
+  {EQUALIZER_PEAK, 10000, 0, 1.0f},
+  {EQUALIZER_HIGH_SHELF, 14000, 0, 0.7f}
+};
+
+static bool Enabled;
+static int Frequency;
+static uint8_t Kernel;
+static EqualizerState Output; /* Only touched by the mixer thread once running */
+
+/* Triple buffer. The main thread owns Sets[Back] and the mixer Sets[Front]; the third one is swapped
+ * in and out of Middle by either side. */
+static EqualizerCoefficients Sets[3];
+static SDL_AtomicInt Middle;
+static int Back = 1, Front = 0;
+
+/* RBJ cookbook coefficients for Band at Rate, written to its two lanes in Set. */
+static void Design(const EqualizerBand *Band, int Rate, EqualizerCoefficients *Set, uint8_t Index) {
+  double B0 = 1, B1 = 0, B2 = 0, A0 = 1, A1 = 0, A2 = 0;
+  double Nyquist = Rate * 0.45;
+
+  if (Band->Gain != 0) {
+    double A = SDL_pow(10.0, Band->Gain / 40.0);
+    double W0 = 2.0 * SDL_PI_D * SDL_min(Band->Frequency, Nyquist) / Rate;
+    double Cos = SDL_cos(W0), Alpha = SDL_sin(W0) / (2.0 * Band->Q), Root = 2.0 * SDL_sqrt(A) * Alpha;
+
+    switch (Band->Type) {
+      case EQUALIZER_LOW_SHELF:
+        B0 = A * ((A + 1) - (A - 1) * Cos + Root);
+        B1 = 2 * A * ((A - 1) - (A + 1) * Cos);
+        B2 = A * ((A + 1) - (A - 1) * Cos - Root);
+        A0 = (A + 1) + (A - 1) * Cos + Root;
+        A1 = -2 * ((A - 1) + (A + 1) * Cos);
+        A2 = (A + 1) + (A - 1) * Cos - Root;
+        break;
+      case EQUALIZER_HIGH_SHELF:
+        B0 = A * ((A + 1) + (A - 1) * Cos + Root);
+        B1 = -2 * A * ((A - 1) + (A + 1) * Cos);
+        B2 = A * ((A + 1) + (A - 1) * Cos - Root);
+        A0 = (A + 1) - (A - 1) * Cos + Root;
+        A1 = 2 * ((A - 1) - (A + 1) * Cos);
+        A2 = (A + 1) - (A - 1) * Cos - Root;
+        break;
+      default:
+        B0 = 1 + Alpha * A;
+        B1 = -2 * Cos;
+        B2 = 1 - Alpha * A;
+        A0 = 1 + Alpha / A;
+        A1 = -2 * Cos;
+        A2 = 1 - Alpha / A;
+        break;
+    }
+  }
+
+  for (uint8_t l = Index * 2; l < Index * 2 + 2; l++) {
+    Set->B0[l] = B0 / A0;
+    Set->B1[l] = B1 / A0;
+    Set->B2[l] = B2 / A0;
+    Set->A1[l] = -A1 / A0;
+    Set->A2[l] = -A2 / A0;
+  }
+
+  Set->Flat[Index] = Band->Gain == 0;
+
+  if (Band->Gain != 0)
+    Set->Count = Index + 1;
+}
+
+static void DesignAll(const EqualizerBand *Bands, int Rate, EqualizerCoefficients *Set) {
+  Set->Count = 0;
+
+  for (uint8_t b = 0; b < EQUALIZER_BANDS; b++)
+    Design(&Bands[b], Rate, Set, b);
+}
+
+static void RunScalar(EqualizerState *State, const EqualizerCoefficients *Set, float *Samples, uint32_t Frames) {
+  int Channels = State->Channels;
+
+  for (uint8_t b = 0; b < Set->Count; b++) {
+    if (Set->Flat[b])
+      continue;
+
+    float B0 = Set->B0[b * 2], B1 = Set->B1[b * 2], B2 = Set->B2[b * 2], A1 = Set->A1[b * 2], A2 = Set->A2[b * 2];
+
+    for (int c = 0; c < Channels; c++) {
+      float S1 = State->Scalar[b][c][0], S2 = State->Scalar[b][c][1];
+
+      for (uint32_t i = 0; i < Frames; i++) {
+        float X = Samples[i * Channels + c], Y = B0 * X + S1;
+
+        S1 = B1 * X + A1 * Y + S2;
+        S2 = B2 * X + A2 * Y;
+        Samples[i * Channels + c] = Y;
+      }
+
+      State->Scalar[b][c][0] = S1;
+      State->Scalar[b][c][1] = S2;
+    }
+  }
+}
+
+#ifdef EQUALIZER_X86
+/* Two bands of interleaved stereo per register: lanes {L, R} of band g and {L, R} of band g + 1,
+ * the second a frame behind. */
+EQUALIZER_TARGET("sse2") static void RunSSE2(EqualizerState *State, const EqualizerCoefficients *Set, float *Samples, uint32_t Frames) {
+  for (uint8_t g = 0; g < Set->Count * 2; g += 4) {
+    __m128 B0 = _mm_loadu_ps(Set->B0 + g), B1 = _mm_loadu_ps(Set->B1 + g), B2 = _mm_loadu_ps(Set->B2 + g);
+    __m128 A1 = _mm_loadu_ps(Set->A1 + g), A2 = _mm_loadu_ps(Set->A2 + g);
+    __m128 S1 = _mm_loadu_ps(State->S1 + g), S2 = _mm_loadu_ps(State->S2 + g), Y = _mm_loadu_ps(State->Y + g);
+
+    for (uint32_t i = 0; i < Frames; i++) {
+      __m128i *Frame = (__m128i *)(Samples + i * 2);
+      __m128 X = _mm_movelh_ps(_mm_castsi128_ps(_mm_loadl_epi64(Frame)), Y);
+
+      Y = _mm_add_ps(_mm_mul_ps(B0, X), S1);
+      S1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(B1, X), _mm_mul_ps(A1, Y)), S2);
+      S2 = _mm_add_ps(_mm_mul_ps(B2, X), _mm_mul_ps(A2, Y));
+
+      _mm_storel_epi64(Frame, _mm_castps_si128(_mm_movehl_ps(Y, Y)));
+    }
+
+    _mm_storeu_ps(State->S1 + g, S1);
+    _mm_storeu_ps(State->S2 + g, S2);
+    _mm_storeu_ps(State->Y + g, Y);
+  }
+}
+
+/* Same as above with four bands per register. The new frame goes into lanes 0 and 1, the rest are
+ * the previous outputs shifted up by a band. */
+EQUALIZER_TARGET("avx2") static void RunAVX2(EqualizerState *State, const EqualizerCoefficients *Set, float *Samples, uint32_t Frames) {
+  const __m256i Shift = _mm256_setr_epi32(0, 1, 0, 1, 2, 3, 4, 5);
+
+  for (uint8_t g = 0; g < Set->Count * 2; g += 8) {
+    __m256 B0 = _mm256_loadu_ps(Set->B0 + g), B1 = _mm256_loadu_ps(Set->B1 + g), B2 = _mm256_loadu_ps(Set->B2 + g);
+    __m256 A1 = _mm256_loadu_ps(Set->A1 + g), A2 = _mm256_loadu_ps(Set->A2 + g);
+    __m256 S1 = _mm256_loadu_ps(State->S1 + g), S2 = _mm256_loadu_ps(State->S2 + g), Y = _mm256_loadu_ps(State->Y + g);
+
+    for (uint32_t i = 0; i < Frames; i++) {
+      __m128i *Frame = (__m128i *)(Samples + i * 2);
+      __m256 In = _mm256_castsi256_ps(_mm256_broadcastq_epi64(_mm_loadl_epi64(Frame)));
+      __m256 X = _mm256_blend_ps(_mm256_permutevar8x32_ps(Y, Shift), In, 0x03);
+
+      Y = _mm256_add_ps(_mm256_mul_ps(B0, X), S1);
+      S1 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(B1, X), _mm256_mul_ps(A1, Y)), S2);
+      S2 = _mm256_add_ps(_mm256_mul_ps(B2, X), _mm256_mul_ps(A2, Y));
+
+      __m128 High = _mm256_extractf128_ps(Y, 1);
+      _mm_storel_epi64(Frame, _mm_castps_si128(_mm_movehl_ps(High, High)));
+    }
+
+    _mm256_storeu_ps(State->S1 + g, S1);
+    _mm256_storeu_ps(State->S2 + g, S2);
+    _mm256_storeu_ps(State->Y + g, Y);
+  }
+}
+#endif
+
+static void Run(uint8_t l_Kernel, EqualizerState *State, const EqualizerCoefficients *Set, float *Samples, uint32_t Frames) {
+  /* Bands that just came into use start from silence rather than whatever they held last time */
+  if (Set->Count > State->Count) {
+    uint8_t Width = KernelWidth[l_Kernel], From = (State->Count + Width - 1) / Width * Width;
+
+    for (uint8_t l = From * 2; l < LANES; l++)
+      State->S1[l] = State->S2[l] = State->Y[l] = 0;
+  }
+
+  /* The scalar kernel skips flat bands, leaving their state frozen, so one turned back on is
+   * cleared too. The SIMD kernels pass flat bands through, which drains their state on its own. */
+  for (uint8_t b = 0; b < Set->Count; b++) {
+    if (!Set->Flat[b] && (b >= State->Count || State->Flat[b]))
+      memset(State->Scalar[b], 0, sizeof(State->Scalar[b]));
+  }
+
+  memcpy(State->Flat, Set->Flat, sizeof(State->Flat));
+  State->Count = Set->Count;
+
+  if (Set->Count == 0)
+    return;
+
+  #ifdef EQUALIZER_X86
+  /* Flush denormals to zero, a decaying filter otherwise slows down to a crawl */
+  unsigned int Control = _mm_getcsr();
+  _mm_setcsr(Control | 0x8040);
+
+  if (l_Kernel == EQUALIZER_AVX2)
+    RunAVX2(State, Set, Samples, Frames);
+  else if (l_Kernel == EQUALIZER_SSE2)
+    RunSSE2(State, Set, Samples, Frames);
+  else
+    RunScalar(State, Set, Samples, Frames);
+
+  _mm_setcsr(Control);
+  #else
+  RunScalar(State, Set, Samples, Frames);
+  #endif
+}
+
+/* The fastest kernel for this CPU. The SIMD ones only handle stereo. */
+static uint8_t PickKernel(int Channels) {
+  #ifdef EQUALIZER_X86
+  if (Channels == 2 && SDL_HasAVX2())
+    return EQUALIZER_AVX2;
+
+  if (Channels == 2 && SDL_HasSSE2())
+    return EQUALIZER_SSE2;
+  #else
+  (void)Channels;
+  #endif
+
+  return EQUALIZER_SCALAR;
+}
+
+/* Only called for float output. */
+void InitializeEqualizer(int l_Frequency, int Channels) {
+  if (Channels > EQUALIZER_MAX_CHANNELS) {
+    SDL_Log("The equalizer is unavailable for %d channels.", Channels);
+    return;
+  }
+
+  Frequency = l_Frequency;
+  Output.Channels = Channels;
+  Kernel = PickKernel(Channels);
+
+  for (uint8_t i = 0; i < 3; i++)
+    DesignAll(EqualizerBands, Frequency, &Sets[i]);
+
+  SDL_SetAtomicInt(&Middle, 2);
+  Enabled = true;
+
+  SDL_Log("Equalizer running the %s kernel.", KernelName[Kernel]);
+}
+
+/* Main thread only. A Gain of 0 turns the band off. */
+void SA_EqualizerSetBand(uint8_t Band, uint8_t Type, float l_Frequency, float Gain, float Q) {
+  if (Band >= EQUALIZER_BANDS)
+    return;
+
+  EqualizerBands[Band] = (EqualizerBand){Type, l_Frequency, SDL_clamp(Gain, -EQUALIZER_MAX_GAIN, EQUALIZER_MAX_GAIN), Q > 0.1f ? Q : 0.1f};
+
+  if (!Enabled)
+    return;
+
+  DesignAll(EqualizerBands, Frequency, &Sets[Back]);
+  Back = SDL_SetAtomicInt(&Middle, Back | FRESH) & ~FRESH;
+}
+
+/* Runs on the mixer thread, from the post-mix callback, on the final interleaved float stream. */
+void SA_EqualizerProcess(float *Samples, uint32_t Frames) {
+  if (!Enabled)
+    return;
+
+  if (SDL_GetAtomicInt(&Middle) & FRESH)
+    Front = SDL_SetAtomicInt(&Middle, Front) & ~FRESH;
+
+  Run(Kernel, &Output, &Sets[Front], Samples, Frames);
+}
+
+#ifndef NDEBUG
+/*
+ * Debug builds only, `SonataAudio --bench-eq`. Runs every kernel this CPU has over ten seconds of
+ * noise in 512 frame blocks, at 48 and 192 kHz, and logs the cost per band.
+ */
+void SA_EqualizerBenchmark() {
+  const int Rates[] = {48000, 192000};
+  const uint8_t Counts[] = {1, 2, 4, 8};
+  const uint32_t Block = 512, Seconds = 10;
+
+  EqualizerBand Bands[EQUALIZER_BANDS];
+  EqualizerCoefficients Set;
+  EqualizerState State = {.Channels = 2};
+
+  for (uint8_t r = 0; r < SDL_arraysize(Rates); r++) {
+    uint32_t Frames = Rates[r] * Seconds;
+    float *Samples = malloc(sizeof(float) * 2 * Frames);
+
+    if (!Samples) {
+      SDL_Log("[FATAL]: Unable to allocate the equalizer benchmark buffer.\n");
+      exit(EXIT_FAILURE);
+    }
+
+    for (uint8_t k = EQUALIZER_SCALAR; k <= PickKernel(2); k++) {
+      for (uint8_t c = 0; c < SDL_arraysize(Counts); c++) {
+        /* Every band boosted, so none of them are skipped */
+        for (uint8_t b = 0; b < EQUALIZER_BANDS; b++)
+          Bands[b] = (EqualizerBand){EQUALIZER_PEAK, 60.0f * (1 << b), b < Counts[c] ? 3.0f : 0.0f, 1.0f};
+
+        DesignAll(Bands, Rates[r], &Set);
+        memset(&State, 0, sizeof(State));
+        State.Channels = 2;
+
+        for (uint32_t i = 0; i < Frames * 2; i++)
+          Samples[i] = SDL_randf() * 0.5f - 0.25f;
+
+        uint64_t Start = SDL_GetPerformanceCounter();
+
+        for (uint32_t i = 0; i < Frames; i += Block)
+          Run(k, &State, &Set, Samples + (size_t)i * 2, SDL_min(Block, Frames - i));
+
+        double Microseconds = (SDL_GetPerformanceCounter() - Start) * 1000000.0 / SDL_GetPerformanceFrequency() / Seconds;
+
+        SDL_Log("[BENCH]: %s, %d Hz, %u bands: %.1f us per second of audio (%.3f%% of a core), %.1f us per band.",
+                KernelName[k], Rates[r], Counts[c], Microseconds, Microseconds / 10000.0, Microseconds / Counts[c]);
+      }
+    }
+
+    free(Samples);
+  }
+}
+#endif
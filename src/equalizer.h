@@ -0,0 +1,50 @@
+#ifndef __SAEQUALIZER__
+#define __SAEQUALIZER__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Parametric equalizer run on the mixed output, a cascade of biquads (RBJ cookbook). Bands left
+ * flat are not run at all, so the stage costs nothing until a band is changed.
+ *
+ * For stereo the SIMD kernels don't vectorise over samples, since every one depends on the one
+ * before it. Instead they put consecutive bands side by side, each band a frame behind the one
+ * before it. SSE2 runs two bands per register and AVX2 four, which delays the output by a frame
+ * for each band added. Other channel counts use the scalar kernel.
+ *
+ * Bands are set from the main thread. The coefficients reach the mixer through a triple buffer
+ * swapped with one atomic exchange, so the mixer never waits on a lock or allocates.
+ */
+#define EQUALIZER_BANDS        8
+#define EQUALIZER_MAX_CHANNELS 8
+#define EQUALIZER_MAX_GAIN     12 /* dB either way */
+
+enum EqualizerType {
+  EQUALIZER_PEAK,
+  EQUALIZER_LOW_SHELF,
+  EQUALIZER_HIGH_SHELF
+};
+
+enum EqualizerKernel {
+  EQUALIZER_SCALAR,
+  EQUALIZER_SSE2,
+  EQUALIZER_AVX2
+};
+
+typedef struct {
+  uint8_t Type;
+  float Frequency, Gain, Q; /* Hz, dB, and the quality factor (or shelf slope) */
+} EqualizerBand;
+
+extern EqualizerBand EqualizerBands[EQUALIZER_BANDS];
+
+void InitializeEqualizer(int Frequency, int Channels);
+void SA_EqualizerSetBand(uint8_t Band, uint8_t Type, float Frequency, float Gain, float Q);
+void SA_EqualizerProcess(float *Samples, uint32_t Frames);
+
+#ifndef NDEBUG
+void SA_EqualizerBenchmark();
+#endif
+
+#endif
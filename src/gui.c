@@ -3,11 +3,19 @@
 #include "render.h"
 #include "pfd.h"
 #include "audio.h"
+#include "crossfade.h"
+#include "equalizer.h"
+#include "arena.h"
+#include "category.h"
+#include "order.h"
+#include "queue.h"
+#include "search.h"
 #include "gui_ext.h"
+#include "import.h"
+#include "playlist.h"
+#include "watch.h"
 
 #ifndef WINDOWS
-#include <dirent.h>
-#include <sys/stat.h>
 #include <SDL3_mixer/SDL_mixer.h>
 #else
 #include <windows.h>
@@ -34,22 +42,36 @@ float l_AudioPosition;
 static float AudioFloat = MIX_MAX_VOLUME;
 
 bool PausedMusic = false; /* Paused using the button */
-static bool InfoOpen = false, PopupOpen = false;
+static bool InfoOpen = false, PopupOpen = false, EqualizerOpen = false;
 
 static mu_Rect SA_Title, SA_Below;
 static mu_Rect SA_Playlist, SA_Popup;
 static mu_Rect SA_InfoFrame, SA_Category;
 static mu_Rect SA_Popup, SA_Search;
+static mu_Rect SA_Equalizer;
 
-char *CurrentCategory = "All";
-char Categories[SA_MAX_CATEGORIES][32];
+uint8_t CurrentCategory = 0;
 char SearchBuffer[128] = {0};
 static const char *InteractButtonText = "Pause";
 static const char *LoopButtonText = "No loop";
+static const char *ShuffleButtonText = "In order";
 
-static AudioData *PlaylistAudios;
-static uint8_t *PlaylistAudioIDs;
-static uint32_t PlaylistBufferSizes;
+/* Crossfade lengths the button cycles through, in seconds */
+static const uint8_t CrossfadeLengths[] = {0, 2, 5, 8, CROSSFADE_MAX_SECONDS};
+static uint8_t CrossfadeChoice;
+
+/* Equalizer sliders, offset by EQUALIZER_MAX_GAIN since SA_Slider only fills from the left */
+static float EqualizerSliders[EQUALIZER_BANDS] = {
+  EQUALIZER_MAX_GAIN, EQUALIZER_MAX_GAIN, EQUALIZER_MAX_GAIN, EQUALIZER_MAX_GAIN,
+  EQUALIZER_MAX_GAIN, EQUALIZER_MAX_GAIN, EQUALIZER_MAX_GAIN, EQUALIZER_MAX_GAIN
+};
+
+/* The playlist view only holds library indices, in display order. PlaylistSearch is the lowered
+ * query the view was last filtered with, so a longer query can narrow it in place. */
+static uint32_t *PlaylistAudioIDs;
+static uint32_t PlaylistCount, PlaylistBufferSizes;
+static char PlaylistSearch[128];
+static double PlaylistSeconds; /* Total length of the view, from the durations read at import */
 
 void (*PopupAction)(void);
 
@@ -66,8 +88,11 @@ int TextHeight(mu_Font font) {
   return r_get_text_height();
 }
 
+/* Refreshed right away, even while an import holds a batch open: the row of a freed track must not
+ * stay on screen where it could be dragged. */
 void FuncRemoveAudio() {
   AudioRemove(SelectedAudio);
+  RefreshPlaylist();
 }
 
 void LowerString(char *Str) {
@@ -75,57 +100,89 @@ void LowerString(char *Str) {
     Str[i] = tolower(Str[i]);
 }
 
-void RefreshPlaylist() {
-  char *l_SearchBuffer = strdup(SearchBuffer);
-  LowerString(l_SearchBuffer);
+/* "m:ss", or "h:mm:ss" from an hour on. An unknown length is left blank. */
+static void FormatDuration(char *Buffer, size_t Size, double Seconds) {
+  uint32_t Total = Seconds > 0 ? (uint32_t)(Seconds + 0.5) : 0;
 
-  if (SA_TotalAudio > PlaylistBufferSizes) {
-    AudioData *l_Audio = realloc(PlaylistAudios, sizeof(AudioData) * SA_TotalAudio);
+  if (Seconds <= 0)
+    Buffer[0] = '\0';
+  else if (Total >= 3600)
+    snprintf(Buffer, Size, "%u:%02u:%02u", Total / 3600, Total / 60 % 60, Total % 60);
+  else
+    snprintf(Buffer, Size, "%u:%02u", Total / 60, Total % 60);
+}
 
-    if (!l_Audio) {
-      SDL_Log("[FATAL]: Unable to realloc PlaylistAudios.\n");
-      exit(EXIT_FAILURE);
-    }
+static void SumPlaylist() {
+  PlaylistSeconds = 0;
+
+  for (uint32_t i = 0; i < PlaylistCount; i++) {
+    if (Audio[PlaylistAudioIDs[i]].Duration > 0)
+      PlaylistSeconds += Audio[PlaylistAudioIDs[i]].Duration;
+  }
+}
 
-    uint8_t *l_AudioIDs = realloc(PlaylistAudioIDs, sizeof(uint8_t) * SA_TotalAudio);
+void RefreshPlaylist() {
+  if (SA_TotalAudio > PlaylistBufferSizes) {
+    uint32_t *l_AudioIDs = realloc(PlaylistAudioIDs, sizeof(uint32_t) * SA_TotalAudio);
 
     if (!l_AudioIDs) {
       SDL_Log("[FATAL]: Unable to realloc PlaylistAudioIDs.\n");
       exit(EXIT_FAILURE);
     }
 
-    PlaylistAudios = l_Audio;
     PlaylistAudioIDs = l_AudioIDs;
+    PlaylistBufferSizes = SA_TotalAudio;
   }
 
-  memset(PlaylistAudios, 0, sizeof(AudioData) * SA_TotalAudio);
-  memset(PlaylistAudioIDs, 0, sizeof(uint8_t) * SA_TotalAudio);
+  memcpy(PlaylistSearch, SearchBuffer, sizeof(PlaylistSearch));
+  LowerString(PlaylistSearch);
 
-  for (uint32_t i = 0; i < SA_TotalAudio; i++) {
-    if (Audio[i].Path[0] == 0)
-      continue;
-    
-    if (strcmp(Audio[i].AssignedList, CurrentCategory) != 0)
+  int32_t Found = SA_SearchQuery(PlaylistSearch, CurrentCategory, PlaylistAudioIDs);
+
+  if (Found != -1) {
+    PlaylistCount = Found;
+    SumPlaylist();
+    return;
+  }
+
+  PlaylistCount = 0;
+
+  for (uint32_t i = SA_OrderFirst(Categories[CurrentCategory].Root); i != ORDER_NIL; i = SA_OrderNext(i)) {
+    if (PlaylistSearch[0] != 0 && !SA_SearchMatches(i, PlaylistSearch))
       continue;
-    
-    if (SearchBuffer[0] != 0) {
-      char *LowerTitle = strdup(Audio[i].Title);
-      LowerString(LowerTitle);
 
-      if (!strstr(LowerTitle, l_SearchBuffer)) {
-        free(LowerTitle);
-        continue;
-      }
+    PlaylistAudioIDs[PlaylistCount++] = i;
+  }
 
-      free(LowerTitle);
-    }
+  SumPlaylist();
+}
 
-    PlaylistAudios[Audio[i].LayoutOrder] = Audio[i];
-    PlaylistAudioIDs[Audio[i].LayoutOrder] = i;
+/* Called when the search box changes. If the new query contains the previous one, every match is
+ * already in the view, so only the current results are filtered again. The first query long enough
+ * for the trigram index goes through RefreshPlaylist instead, since the index beats a large view. */
+static void SearchPlaylist() {
+  char l_SearchBuffer[sizeof(PlaylistSearch)];
+
+  memcpy(l_SearchBuffer, SearchBuffer, sizeof(l_SearchBuffer));
+  LowerString(l_SearchBuffer);
+
+  bool FirstIndexed = strlen(l_SearchBuffer) >= SEARCH_MIN_QUERY && strlen(PlaylistSearch) < SEARCH_MIN_QUERY;
+
+  if (FirstIndexed || !strstr(l_SearchBuffer, PlaylistSearch)) {
+    RefreshPlaylist();
+    return;
   }
 
-  PlaylistBufferSizes = SA_TotalAudio;
-  free(l_SearchBuffer);
+  uint32_t Count = 0;
+
+  for (uint32_t i = 0; i < PlaylistCount; i++) {
+    if (SA_SearchMatches(PlaylistAudioIDs[i], l_SearchBuffer))
+      PlaylistAudioIDs[Count++] = PlaylistAudioIDs[i];
+  }
+
+  PlaylistCount = Count;
+  memcpy(PlaylistSearch, l_SearchBuffer, sizeof(PlaylistSearch));
+  SumPlaylist();
 }
 
 void InitializeGUI() {
@@ -136,18 +193,20 @@ void InitializeGUI() {
   SA_Category = (mu_Rect){0, 24, CATEGORY_WIDTH, CATEGORY_HEIGHT};
   SA_Popup = (mu_Rect){WINDOW_WIDTH / 2 - POPUP_WIDTH / 2, WINDOW_HEIGHT / 2 - POPUP_HEIGHT / 2, POPUP_WIDTH, POPUP_HEIGHT};
   SA_Search = (mu_Rect){SA_Playlist.x, SA_Playlist.y - 30, SEARCH_WIDTH, SEARCH_HEIGHT};
+  SA_Equalizer = (mu_Rect){WINDOW_WIDTH / 2 - EQUALIZER_WIDTH / 2, WINDOW_HEIGHT / 2 - EQUALIZER_HEIGHT / 2, EQUALIZER_WIDTH, EQUALIZER_HEIGHT};
   
   PlaylistBufferSizes = SA_TotalAudio;
-  PlaylistAudios = calloc(SA_TotalAudio, sizeof(AudioData));
-  PlaylistAudioIDs = calloc(SA_TotalAudio, sizeof(uint8_t));
+  PlaylistAudioIDs = calloc(SA_TotalAudio, sizeof(uint32_t));
 }
 
 void MainWindow(mu_Context *Context) {
   mu_Container *InfoContainer = mu_get_container(Context, "INFO");
   mu_Container *PopupContainer = mu_get_container(Context, "POPUP");
+  mu_Container *EqualizerContainer = mu_get_container(Context, "EQUALIZER");
 
   if (!InfoContainer->open) {InfoOpen = false;}
   if (!PopupContainer->open) {PopupOpen = false;}
+  if (!EqualizerContainer->open) {EqualizerOpen = false;}
 
   /* Title */
   if (mu_begin_window_ex(Context, "Sonata Audio", SA_Title, TitleOpt)) {
@@ -170,69 +229,73 @@ void MainWindow(mu_Context *Context) {
       if (!Path) {
         SDL_Log("Directory is NULL.");
       } else {
-        size_t PathLen = strlen(Path);
+        SA_ImportDirectory(Path, CurrentCategory);
+        SA_WatchDirectory(Path, CurrentCategory);
+      }
+    }
 
-        #ifndef WINDOWS
-        DIR *Directory;
-        struct dirent *Entry;
+    mu_layout_set_next(Context, (mu_Rect){WINDOW_WIDTH - 190, 5, 90, 20}, 1);
+    if (mu_button(Context, "Load playlist")) {
+      const char *Path = OpenDialogue(PFD_FILE);
 
-        if ((Directory = opendir(Path)) != NULL) {
-          char FullPath[PATH_MAX];
-          
-          memcpy(FullPath, Path, PathLen);
-
-          while ((Entry = readdir(Directory)) != NULL) {
-            struct stat Stats;
-            
-            /* Not interested into those directories. */
-            if (strcmp(Entry->d_name, ".") == 0 || strcmp(Entry->d_name, "..") == 0)
-              continue;
-            
-            /* Compute absolute path */
-            FullPath[PathLen] = '\0';
-            strcat(FullPath, "/");
-            strcat(FullPath, Entry->d_name);
-
-            if (stat(FullPath, &Stats) == -1) {
-              SDL_Log("stat() failed on %s.", Entry->d_name);
-              continue;
-            }
-
-            if (S_ISREG(Stats.st_mode) != 0)
-              AddAudio(FullPath, CurrentCategory);
-          }
+      if (Path)
+        SA_PlaylistImport(Path);
+      else
+        SDL_Log("Path is NULL.");
+    }
 
-          closedir(Directory);
-        } 
-        #else
-        char AudioPath[MAX_PATH];
-
-        TCHAR DirectoryPath[MAX_PATH];
-        HANDLE HandleFind = INVALID_HANDLE_VALUE;
-        WIN32_FIND_DATA FileData;
-        
-        strcat(DirectoryPath, Path);
-        strcat(DirectoryPath, "\\*");
-        memcpy(AudioPath, Path, PathLen);
-
-        HandleFind = FindFirstFile(DirectoryPath, &FileData);
-
-        if (HandleFind != INVALID_HANDLE_VALUE) {
-          do {
-            /* Maybe one day we'll handle multiple directories. Maybe. */
-            if (!(FileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-              AudioPath[PathLen] = '\0';
-              strcat(AudioPath, "\\");
-              strcat(AudioPath, FileData.cFileName);
-
-              AddAudio(AudioPath, NULL);
-            }
-          } while (FindNextFile(HandleFind, &FileData) != 0);
-        } else {
-          SDL_Log("INVALID_HANDLE_VALUE returned by FindFirstFile.");
-        }
-        #endif
-      }
+    mu_layout_set_next(Context, (mu_Rect){WINDOW_WIDTH - 95, 5, 90, 20}, 1);
+    if (mu_button(Context, "Export")) {
+      const char *Path = OpenDialogue(PFD_SAVE);
+
+      if (Path)
+        SA_PlaylistExport(CurrentCategory, Path);
+      else
+        SDL_Log("Path is NULL.");
+    }
+
+    char CrossfadeText[24];
+
+    if (CrossfadeLengths[CrossfadeChoice] > 0)
+      snprintf(CrossfadeText, sizeof(CrossfadeText), "Crossfade %us", CrossfadeLengths[CrossfadeChoice]);
+    else
+      snprintf(CrossfadeText, sizeof(CrossfadeText), "No crossfade");
+
+    mu_layout_set_next(Context, (mu_Rect){WINDOW_WIDTH - 285, 5, 90, 20}, 1);
+    if (mu_button(Context, CrossfadeText)) {
+      CrossfadeChoice = (CrossfadeChoice + 1) % (sizeof(CrossfadeLengths) / sizeof(CrossfadeLengths[0]));
+      ConfigureCrossfade(CrossfadeLengths[CrossfadeChoice], CrossfadeCurve);
+    }
+
+    mu_layout_set_next(Context, (mu_Rect){WINDOW_WIDTH - 475, 5, 90, 20}, 1);
+    if (mu_button(Context, "Equalizer")) {
+      EqualizerOpen = true;
+      EqualizerContainer->open = 1;
+    }
+
+    mu_layout_set_next(Context, (mu_Rect){WINDOW_WIDTH - 380, 5, 90, 20}, 1);
+    if (mu_button(Context, CrossfadeCurve == CROSSFADE_LINEAR ? "Linear fade" : "Equal power"))
+      ConfigureCrossfade(CrossfadeSeconds, CrossfadeCurve == CROSSFADE_LINEAR ? CROSSFADE_EQUAL_POWER : CROSSFADE_LINEAR);
+
+    uint32_t ImportDone, ImportTotal;
+
+    if (SA_ImportProgress(&ImportDone, &ImportTotal)) {
+      char ProgressBuf[48];
+
+      snprintf(ProgressBuf, sizeof(ProgressBuf), "Importing %u/%u", ImportDone, ImportTotal);
+      mu_layout_set_next(Context, (mu_Rect){2, 5, 120, 20}, 1);
+      mu_label(Context, ProgressBuf);
+
+      mu_layout_set_next(Context, (mu_Rect){2, 27, 60, 20}, 1);
+      if (mu_button(Context, "Cancel"))
+        SA_ImportCancel();
+    } else if (PlaylistCount > 0) {
+      char Length[24], SummaryBuf[48];
+
+      FormatDuration(Length, sizeof(Length), PlaylistSeconds);
+      snprintf(SummaryBuf, sizeof(SummaryBuf), Length[0] ? "%u tracks, %s" : "%u tracks", PlaylistCount, Length);
+      mu_layout_set_next(Context, (mu_Rect){2, 5, 120, 20}, 1);
+      mu_label(Context, SummaryBuf);
     }
 
     /*if (mu_button(Context, "Settings")) {
@@ -253,6 +316,31 @@ void MainWindow(mu_Context *Context) {
       PausedMusic = !PausedMusic;
     }
 
+    mu_layout_set_next(Context, (mu_Rect){107, 50, 80, 20}, 1);
+
+    if (mu_button_ex(Context, ShuffleButtonText, 0, MU_OPT_ALIGNCENTER)) {
+      SA_QueueSetShuffle(!QueueShuffle, AudioCurrentIndex);
+      ShuffleButtonText = QueueShuffle ? "Shuffled" : "In order";
+    }
+
+    mu_layout_set_next(Context, (mu_Rect){InteractionRect.x - 25, InteractionRect.y, 20, InteractionRect.h}, 1);
+
+    if (mu_button_ex(Context, "<", 0, MU_OPT_ALIGNCENTER) && AudioCurrentIndex != -1) {
+      int32_t Previous = SA_QueuePrevious(AudioCurrentIndex);
+
+      if (Previous != -1)
+        PlayAudio(SA_String(Audio[Previous].Path));
+    }
+
+    mu_layout_set_next(Context, (mu_Rect){LoopRect.x + LoopRect.w + 5, LoopRect.y, 20, LoopRect.h}, 1);
+
+    if (mu_button_ex(Context, ">", 0, MU_OPT_ALIGNCENTER) && AudioCurrentIndex != -1) {
+      int32_t Next = SA_QueueNext(AudioCurrentIndex);
+
+      if (Next != -1)
+        PlayAudio(SA_String(Audio[Next].Path));
+    }
+
     mu_layout_set_next(Context, LoopRect, 1);
     
     if (mu_button_ex(Context, LoopButtonText, 0, MU_OPT_ALIGNCENTER)) {
@@ -298,7 +386,7 @@ void MainWindow(mu_Context *Context) {
     mu_layout_set_next(Context, (mu_Rect){-5, 0, SEARCH_WIDTH, 20}, 1);
     
     if (mu_textbox(Context, SearchBuffer, sizeof(SearchBuffer)) & MU_RES_CHANGE)
-      RefreshPlaylist();
+      SearchPlaylist();
 
     mu_end_window(Context);
   }
@@ -306,19 +394,53 @@ void MainWindow(mu_Context *Context) {
   /* Playlist */
   if (mu_begin_window_ex(Context, "PLAYLIST", SA_Playlist, PlaylistOpt)) {
     int l_Width[] = {PLAYLIST_WIDTH - 20};
+    int RowWidths[] = {PLAYLIST_WIDTH - 80, 55};
 
     mu_Container *Container = mu_get_container(Context, "Menu");
     if (SelectedAudio == -1) {Container->open = 0;}
     
-    for (uint32_t i = 0; i < PlaylistBufferSizes; i++) {
-      if (PlaylistAudios[i].Path[0] == 0)
-        continue;
+    /* Only rows inside the visible part of the list get controls. The rows above and below are
+     * covered by one spacer each, so the scroll extent still matches the whole playlist. */
+    mu_Container *PlaylistContainer = mu_get_current_container(Context);
+    int RowStride = ROW_HEIGHT + Context->style->spacing;
+    uint32_t First = mu_min((uint32_t)mu_max(PlaylistContainer->scroll.y, 0) / RowStride, PlaylistCount);
+    uint32_t Last = mu_min(First + PlaylistContainer->body.h / RowStride + 2, PlaylistCount);
+
+    if (First > 0) {
+      mu_layout_row(Context, 1, l_Width, First * RowStride - Context->style->spacing);
+      mu_layout_next(Context);
+    }
 
-      if (Audio[PlaylistAudioIDs[i]].Path[0] == 0)
-        continue;
+    for (uint32_t i = First; i < Last; i++) {
+      char Length[24];
+
+      FormatDuration(Length, sizeof(Length), Audio[PlaylistAudioIDs[i]].Duration);
+      mu_layout_row(Context, 2, RowWidths, ROW_HEIGHT);
+      SA_AudioButton(Context, SA_String(Audio[PlaylistAudioIDs[i]].Title), PlaylistAudioIDs[i]);
+      mu_label(Context, Length);
+    }
 
-      mu_layout_row(Context, 1, l_Width, 25);
-      SA_AudioButton(Context, PlaylistAudios[i].Title, PlaylistAudioIDs[i]);
+    if (Last < PlaylistCount) {
+      mu_layout_row(Context, 1, l_Width, (PlaylistCount - Last) * RowStride - Context->style->spacing);
+      mu_layout_next(Context);
+    }
+
+    /* Dragging: outline the row under the mouse, and move the track there in one step on release */
+    int Dropped = SA_EndSliding(Context);
+
+    if ((Dropped != -1 || SA_GetSliding() != -1) && PlaylistCount > 0) {
+      int RowsTop = PlaylistContainer->body.y + Context->style->padding - PlaylistContainer->scroll.y;
+      int MouseRow = (Context->mouse_pos.y - RowsTop) / RowStride;
+      uint32_t Row = mu_clamp(MouseRow, 0, (int)PlaylistCount - 1);
+
+      if (Dropped != -1) {
+        SA_CategoryMove(Audio[Dropped].Category, Dropped, SA_CategoryPosition(PlaylistAudioIDs[Row]));
+        SA_QueueMove(Dropped);
+        RefreshPlaylist();
+      } else {
+        mu_Rect Target = {PlaylistContainer->body.x + Context->style->padding, RowsTop + Row * RowStride, l_Width[0], ROW_HEIGHT};
+        mu_draw_box(Context, Target, Context->style->colors[MU_COLOR_TEXT]);
+      }
     }
     
     mu_Rect l_Rect = mu_layout_next(Context);
@@ -327,8 +449,10 @@ void MainWindow(mu_Context *Context) {
     if (mu_button(Context, "+")) {
       const char *Path = OpenDialogue(PFD_FILE);
 
-      if (Path)
-        AddAudio((char *)Path, CurrentCategory);
+      if (Path && SA_IsPlaylist(Path))
+        SA_PlaylistImport(Path);
+      else if (Path)
+        SA_ImportFile(Path, CurrentCategory);
       else
         SDL_Log("Path is NULL.\n");
     }
@@ -355,20 +479,14 @@ void MainWindow(mu_Context *Context) {
   
   /* Directories */
   if (mu_begin_window_ex(Context, "CATEGORIES", SA_Category, CategoryOpt)) { 
-    static uint8_t TotalCategoryButtons = 2;
-    
     mu_layout_row(Context, 1, (int[]){70}, 20);
-    if (SA_CategoryButton(Context, "All", 0)) {
-      CurrentCategory = "All";
-      RefreshPlaylist();
-    }
     
     for (uint8_t i = 0; i < SA_MAX_CATEGORIES; i++) {
-      if (Categories[i][0] == 0)
+      if (Categories[i].Name == 0)
         continue;
        
-      if (SA_CategoryButton(Context, Categories[i], 0)) {
-        CurrentCategory = Categories[i];
+      if (SA_CategoryButton(Context, SA_String(Categories[i].Name), 0)) {
+        CurrentCategory = i;
         RefreshPlaylist();
       }
     }
@@ -378,16 +496,14 @@ void MainWindow(mu_Context *Context) {
     PlusRect.w = PlusRect.h = 15;
     
     mu_layout_set_next(Context, PlusRect, 0);
-    if (TotalCategoryButtons - 1 < SA_MAX_CATEGORIES) {
+    if (Categories[SA_MAX_CATEGORIES - 1].Name == 0) {
       if (mu_button(Context, "+")) {
         for (uint8_t i = 0; i < SA_MAX_CATEGORIES; i++) {
-          if (Categories[i][0] == 0) {
-            char Buf[5];
+          if (Categories[i].Name == 0) {
+            char Name[16];
           
-            TotalCategoryButtons += 1;
-            sprintf(Buf, "%u", i); /* me when itoa doesn't want to compile */
-            memcpy(Categories[i], "Category ", 9);
-            memcpy(Categories[i] + 9, Buf, strlen(Buf));
+            snprintf(Name, sizeof(Name), "Category %u", i);
+            SA_CreateCategory(Name);
             break;
           }
         } 
@@ -433,16 +549,13 @@ void MainWindow(mu_Context *Context) {
     Context->hover_root = Context->next_hover_root = InfoContainer;
     mu_bring_to_front(Context, InfoContainer);
 
-    char ArtistBuf[128 + 8] = {0};
-    char CopyrightBuf[128 + 11] = {0};
-    char AlbumBuf[128 + 7] = {0};
+    char ArtistBuf[128 + 8];
+    char CopyrightBuf[128 + 11];
+    char AlbumBuf[128 + 7];
 
-    memcpy(ArtistBuf, "Artist: ", 8);
-    memcpy(CopyrightBuf, "Copyright: ", 11);
-    memcpy(AlbumBuf, "Album: ", 7);
-    memcpy(ArtistBuf + 8, Audio[SelectedAudio].TagArtist, strlen(Audio[SelectedAudio].TagArtist));
-    memcpy(CopyrightBuf + 11, Audio[SelectedAudio].TagCopyright, strlen(Audio[SelectedAudio].TagCopyright));
-    memcpy(AlbumBuf + 7, Audio[SelectedAudio].TagAlbum, strlen(Audio[SelectedAudio].TagAlbum));
+    snprintf(ArtistBuf, sizeof(ArtistBuf), "Artist: %s", SA_String(Audio[SelectedAudio].TagArtist));
+    snprintf(CopyrightBuf, sizeof(CopyrightBuf), "Copyright: %s", SA_String(Audio[SelectedAudio].TagCopyright));
+    snprintf(AlbumBuf, sizeof(AlbumBuf), "Album: %s", SA_String(Audio[SelectedAudio].TagAlbum));
 
     /* Columns hate me */
     mu_layout_row(Context, 1, (int[]){INFO_WIDTH - 25}, 25);
@@ -456,6 +569,43 @@ void MainWindow(mu_Context *Context) {
     
     mu_end_window(Context);
   }
+
+  EqualizerContainer->open = EqualizerOpen;
+  EqualizerContainer->zindex = 2;
+
+  /* EQUALIZER */
+  if (mu_begin_window_ex(Context, "EQUALIZER", SA_Equalizer, InfoFrameOpt)) {
+    Context->hover_root = Context->next_hover_root = EqualizerContainer;
+    mu_bring_to_front(Context, EqualizerContainer);
+
+    for (uint8_t i = 0; i < EQUALIZER_BANDS; i++) {
+      EqualizerBand *Band = &EqualizerBands[i];
+      char BandBuf[32];
+
+      if (Band->Frequency >= 1000)
+        snprintf(BandBuf, sizeof(BandBuf), "%.1f kHz %+.1f", Band->Frequency / 1000, Band->Gain);
+      else
+        snprintf(BandBuf, sizeof(BandBuf), "%.0f Hz %+.1f", Band->Frequency, Band->Gain);
+
+      mu_layout_row(Context, 2, (int[]){100, EQUALIZER_WIDTH - 125}, 20);
+      mu_label(Context, BandBuf);
+
+      /* Half a decibel steps, so a band can be put back to exactly flat */
+      if (SA_Slider(Context, &EqualizerSliders[i], 0, EQUALIZER_MAX_GAIN * 2) & MU_RES_CHANGE)
+        SA_EqualizerSetBand(i, Band->Type, Band->Frequency, SDL_roundf(EqualizerSliders[i] * 2) / 2 - EQUALIZER_MAX_GAIN, Band->Q);
+    }
+
+    mu_layout_row(Context, 1, (int[]){60}, 20);
+
+    if (mu_button(Context, "Flat")) {
+      for (uint8_t i = 0; i < EQUALIZER_BANDS; i++) {
+        EqualizerSliders[i] = EQUALIZER_MAX_GAIN;
+        SA_EqualizerSetBand(i, EqualizerBands[i].Type, EqualizerBands[i].Frequency, 0, EqualizerBands[i].Q);
+      }
+    }
+
+    mu_end_window(Context);
+  }
 }
 
 void ProcessContextFrame(mu_Context *Context) {
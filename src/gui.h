@@ -11,12 +11,13 @@
 #define CATEGORY_HEIGHT   WINDOW_HEIGHT - BELOW_HEIGHT
 #define POPUP_WIDTH       250
 #define POPUP_HEIGHT      80
+#define EQUALIZER_WIDTH   300
+#define EQUALIZER_HEIGHT  250
 #define PLAYLIST_WIDTH    WINDOW_WIDTH - CATEGORY_WIDTH - 5
 #define PLAYLIST_HEIGHT   WINDOW_HEIGHT - BELOW_HEIGHT - 30 /* -30 for the SEARCH_HEIGHT */
 #define SEARCH_WIDTH      PLAYLIST_WIDTH
 #define SEARCH_HEIGHT     30
-
-#define SA_MAX_CATEGORIES 32
+#define ROW_HEIGHT        25
 
 enum LoopEnum {
   LOOP_NONE,
@@ -25,7 +26,7 @@ enum LoopEnum {
 };
 
 extern int LoopStatus;
-extern char *CurrentCategory;
+extern uint8_t CurrentCategory;
 
 int TextWidth(mu_Font font, const char *text, int len);
 int TextHeight(mu_Font font);
@@ -1,4 +1,6 @@
 #include "audio.h"
+#include "arena.h"
+#include "category.h"
 #include "gui_ext.h"
 #include "gui.h"
 
@@ -7,13 +9,21 @@
 static int SlidingAudio = -1;
 static mu_Id CurrentCategoryID = 0;
 
-int32_t SA_GetAudioByOrder(uint8_t RequestedOrder) {
-  for (uint32_t i = 0; i < SA_TotalAudio; i++) {
-    if (Audio[i].LayoutOrder == RequestedOrder)
-      return i;
+int SA_GetSliding() {
+  return SlidingAudio;
+}
+
+/* Returns the dragged track once the mouse button is released, -1 otherwise. This doesn't depend on
+ * the dragged row being drawn, since it may have been scrolled out of view. */
+int SA_EndSliding(mu_Context *Context) {
+  int Dropped = -1;
+
+  if (SlidingAudio != -1 && Context->mouse_down != MU_MOUSE_LEFT) {
+    Dropped = SlidingAudio;
+    SlidingAudio = -1;
   }
 
-  return -1;
+  return Dropped;
 }
 
 int SA_AudioButton(mu_Context *Context, const char *Name, int AudioID) {
@@ -28,7 +38,7 @@ int SA_AudioButton(mu_Context *Context, const char *Name, int AudioID) {
   int Result = 0;
   
   if (Context->mouse_pressed == MU_MOUSE_LEFT && mu_mouse_over(Context, MainRect)) {
-    PlayAudio(Audio[AudioID].Path);
+    PlayAudio(SA_String(Audio[AudioID].Path));
     Result |= MU_RES_CHANGE;
   } else if (Context->mouse_pressed == MU_MOUSE_RIGHT && mu_mouse_over(Context, MainRect) && AudioID != AudioCurrentIndex) {
     mu_open_popup(Context, "Menu");
@@ -36,35 +46,8 @@ int SA_AudioButton(mu_Context *Context, const char *Name, int AudioID) {
     Result |= MU_RES_CHANGE;
   } else if (Context->mouse_pressed == MU_MOUSE_LEFT && mu_mouse_over(Context, Slider)) {
     SlidingAudio = AudioID;
-  } else if (Context->mouse_down != MU_MOUSE_LEFT && AudioID == SlidingAudio) {
-    SlidingAudio = -1;
   }
 
-  if (SlidingAudio == AudioID) {
-    int UpperAudio = SA_GetAudioByOrder(Audio[AudioID].LayoutOrder + 1);
-    int LowerAudio = SA_GetAudioByOrder(Audio[AudioID].LayoutOrder - 1);
-
-    if (LowerAudio > -1) {
-      if (mu_mouse_over(Context, (mu_Rect){Slider.x, Slider.y - Slider.h - Context->style->padding, Slider.w, Slider.h})) {
-        uint32_t LowerOrder = Audio[LowerAudio].LayoutOrder;
-        
-        Audio[LowerAudio].LayoutOrder = Audio[AudioID].LayoutOrder;
-        Audio[AudioID].LayoutOrder = LowerOrder;
-      }
-    }
-
-    if (UpperAudio > -1) {
-      if (mu_mouse_over(Context, (mu_Rect){Slider.x, Slider.y + Slider.h + Context->style->padding, Slider.w, Slider.h})) {
-        uint32_t UpperOrder = Audio[UpperAudio].LayoutOrder;
-        
-        Audio[UpperAudio].LayoutOrder = Audio[AudioID].LayoutOrder;
-        Audio[AudioID].LayoutOrder = UpperOrder;
-      }
-    }
-
-    RefreshPlaylist();
-  }
-  
   mu_draw_control_frame(Context, ButtonID, Slider, SlidingAudio != AudioID ? MU_COLOR_BUTTON : MU_COLOR_BASE, MU_OPT_NOBORDER);
   mu_draw_control_frame(Context, ButtonID, MainRect, AudioCurrentIndex != AudioID ? MU_COLOR_BUTTON : MU_COLOR_BASE, MU_OPT_NOBORDER);
   mu_draw_control_text(Context, Name, MainRect, MU_COLOR_TEXT, 0);
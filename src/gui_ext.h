@@ -4,6 +4,8 @@
 #include "microui.h"
 
 int SA_AudioButton(mu_Context *Context, const char *Name, int AudioID);
+int SA_GetSliding();
+int SA_EndSliding(mu_Context *Context);
 int SA_CategoryButton(mu_Context *Context, const char *Text, int Opt);
 int SA_Slider(mu_Context *Context, mu_Real *Value, int Low, int High);
 
@@ -0,0 +1,915 @@
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef WINDOWS
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+#include "arena.h"
+#include "audio.h"
+#include "cache.h"
+#include "category.h"
+#include "content.h"
+#include "import.h"
+#include "playlist.h"
+#include "tags.h"
+
+/* Time the main loop may spend inserting finished tracks per frame, and how often the playlist is
+ * refreshed while an import is running. */
+#define IMPORT_POLL_BUDGET_NS   (4 * 1000000ULL)
+#define IMPORT_REFRESH_NS       (250 * 1000000ULL)
+
+enum ImportKind {
+  IMPORT_FILE,
+  IMPORT_DIRECTORY,
+  IMPORT_VALIDATE, /* A cached track, re-read only if its stamp changed */
+  IMPORT_CHANGED,  /* A path the watcher saw change: added, re-read or removed, whichever applies */
+  IMPORT_RESCAN,   /* A directory walked for files the library doesn't have yet */
+  IMPORT_PROBE,    /* A file found by a rescan, only its path comes back */
+  IMPORT_PLAYLIST, /* PLAYLIST_CHUNK entries of a playlist, Size is the offset to resume at. Its
+                    * result, if any, asks for the next chunk */
+  IMPORT_ENTRY     /* A playlist entry, only its path comes back */
+};
+
+typedef struct ImportJob {
+  struct ImportJob *Next;
+  uint32_t Generation;
+  uint8_t Category;
+  uint8_t Kind;
+  int64_t MTime;
+  uint64_t Size;
+  uint64_t Ordinal; /* Position in the playlist the file came from, 0 otherwise */
+  bool Play;        /* Played once it is in the library, see SA_ImportPlay() */
+  char Path[];
+} ImportJob;
+
+/* Every string of a finished track lives in Strings, back to back. Path comes first. */
+typedef struct {
+  uint32_t Generation;
+  uint8_t Category;
+  uint8_t Kind;
+  bool Failed;
+  bool Rejected; /* Not audio, turned down by the prefilter */
+  bool Gone;     /* Failed because the file was deleted, see SA_FileGone() */
+  bool Play;
+  float Duration;
+  int64_t MTime;
+  uint64_t Size;
+  uint64_t Hash; /* 0 if the file couldn't be hashed */
+  uint64_t Ordinal;
+  uint16_t Title, Artist, Album, Copyright;
+  char Strings[];
+} ImportResult;
+
+typedef struct {
+  SDL_AtomicInt Sequence;
+  ImportResult *Result;
+} RingCell;
+
+static SDL_Thread *Workers[IMPORT_MAX_WORKERS];
+static int WorkerCount;
+
+static SDL_Mutex *JobLock;
+static SDL_Condition *JobReady;
+static ImportJob *JobHead, *JobTail;
+static bool Quit;
+
+static RingCell Ring[IMPORT_RING_SIZE];
+static SDL_AtomicInt RingHead, RingTail;
+
+/* Pending counts jobs not yet accounted for by the main thread; it reaching 0 ends an import. A
+ * cancel bumps Generation, and anything tagged with an older one is dropped on sight. Validation,
+ * the watcher and rescans keep the library in sync with the disk rather than import anything the
+ * user asked for, so they are tagged IMPORT_BACKGROUND and a cancel leaves them be. */
+#define IMPORT_BACKGROUND UINT32_MAX
+
+static SDL_AtomicInt Pending, Generation, Total;
+static uint32_t Done, Failed, Rejected, Duplicates, Added, Changed, Missing;
+static uint64_t LastRefresh;
+static bool Batching; /* An audio batch is held open from the first result to the end of the import */
+
+/* Bounded MPMC ring (Vyukov). Each cell's sequence tells whether it is free for the producer at
+ * position Pos (Sequence == Pos) or holds a result for the consumer (Sequence == Pos + 1). */
+static bool RingPush(ImportResult *Result) {
+  uint32_t Pos = SDL_GetAtomicInt(&RingTail);
+
+  for (;;) {
+    RingCell *Cell = &Ring[Pos & (IMPORT_RING_SIZE - 1)];
+    int32_t Diff = (int32_t)((uint32_t)SDL_GetAtomicInt(&Cell->Sequence) - Pos);
+
+    if (Diff == 0) {
+      if (SDL_CompareAndSwapAtomicInt(&RingTail, Pos, Pos + 1)) {
+        Cell->Result = Result;
+        SDL_SetAtomicInt(&Cell->Sequence, Pos + 1);
+        return true;
+      }
+    } else if (Diff < 0) {
+      return false;
+    }
+
+    Pos = SDL_GetAtomicInt(&RingTail);
+  }
+}
+
+static ImportResult *RingPop() {
+  uint32_t Pos = SDL_GetAtomicInt(&RingHead);
+
+  for (;;) {
+    RingCell *Cell = &Ring[Pos & (IMPORT_RING_SIZE - 1)];
+    int32_t Diff = (int32_t)((uint32_t)SDL_GetAtomicInt(&Cell->Sequence) - (Pos + 1));
+
+    if (Diff == 0) {
+      if (SDL_CompareAndSwapAtomicInt(&RingHead, Pos, Pos + 1)) {
+        ImportResult *Result = Cell->Result;
+        SDL_SetAtomicInt(&Cell->Sequence, Pos + IMPORT_RING_SIZE);
+        return Result;
+      }
+    } else if (Diff < 0) {
+      return NULL;
+    }
+
+    Pos = SDL_GetAtomicInt(&RingHead);
+  }
+}
+
+static bool Cancelled(uint32_t l_Generation) {
+  return l_Generation != IMPORT_BACKGROUND && l_Generation != (uint32_t)SDL_GetAtomicInt(&Generation);
+}
+
+static ImportJob *NewJob(const char *Path, uint8_t Category, uint8_t Kind, uint32_t l_Generation, int64_t MTime, uint64_t Size) {
+  size_t Length = strlen(Path) + 1;
+  ImportJob *Job = malloc(sizeof(ImportJob) + Length);
+
+  if (!Job) {
+    SDL_Log("[FATAL]: Unable to allocate an import job.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  Job->Next = NULL;
+  Job->Generation = l_Generation;
+  Job->Category = Category;
+  Job->Kind = Kind;
+  Job->MTime = MTime;
+  Job->Size = Size;
+  Job->Ordinal = 0;
+  Job->Play = false;
+  memcpy(Job->Path, Path, Length);
+
+  return Job;
+}
+
+/* Appends a chain of Count jobs under a single lock. */
+static void PushJobs(ImportJob *First, ImportJob *Last, uint32_t Count) {
+  SDL_AddAtomicInt(&Pending, Count);
+  SDL_LockMutex(JobLock);
+
+  if (JobTail)
+    JobTail->Next = First;
+  else
+    JobHead = First;
+
+  JobTail = Last;
+
+  if (Count > 1)
+    SDL_BroadcastCondition(JobReady);
+  else
+    SDL_SignalCondition(JobReady);
+
+  SDL_UnlockMutex(JobLock);
+}
+
+static void PushJob(const char *Path, uint8_t Category, uint8_t Kind, uint32_t l_Generation) {
+  ImportJob *Job = NewJob(Path, Category, Kind, l_Generation, 0, 0);
+
+  if (Kind == IMPORT_FILE)
+    SDL_AddAtomicInt(&Total, 1);
+
+  PushJobs(Job, Job, 1);
+}
+
+static ImportResult *ReadTrack(ImportJob *Job) {
+  AudioTags l_Tags;
+  int64_t MTime = 0;
+  uint64_t FileSize = 0, Hash = 0;
+  bool Probe = Job->Kind == IMPORT_PROBE || Job->Kind == IMPORT_ENTRY || Job->Kind == IMPORT_PLAYLIST;
+  bool NotAudio = (Job->Kind == IMPORT_FILE || Job->Kind == IMPORT_CHANGED) && !SA_IsAudioFile(Job->Path);
+  bool Loaded = !Probe && !NotAudio && SA_FileStamp(Job->Path, &MTime, &FileSize) && SA_ReadTags(Job->Path, &l_Tags);
+  const char *Tags[5] = {Job->Path, l_Tags.Title, l_Tags.Artist, l_Tags.Album, l_Tags.Copyright};
+  size_t Lengths[5] = {0};
+  size_t Size = 0;
+
+  /* The tag reader just touched the file, so the samples are likely still in the page cache */
+  if (Loaded)
+    SA_ContentHash(Job->Path, &Hash);
+
+  if (!Loaded) {
+    memset(&l_Tags, 0, sizeof(AudioTags));
+
+    if (!NotAudio && !Probe)
+      SDL_Log("Failed to load \"%s\": %s", Job->Path, SDL_GetError());
+  }
+
+  /* Paths are bounded by PATH_MAX and tags by TAG_LENGTH, so every offset fits in 16 bits */
+  for (uint8_t i = 0; i < 5; i++) {
+    Lengths[i] = strlen(Tags[i]);
+    Size += Lengths[i] + 1;
+  }
+
+  ImportResult *Result = malloc(sizeof(ImportResult) + Size);
+
+  if (!Result) {
+    SDL_Log("[FATAL]: Unable to allocate an import result.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  uint16_t Offsets[5];
+  size_t Offset = 0;
+
+  for (uint8_t i = 0; i < 5; i++) {
+    Offsets[i] = Offset;
+    memcpy(Result->Strings + Offset, Tags[i], Lengths[i]);
+    Result->Strings[Offset + Lengths[i]] = '\0';
+    Offset += Lengths[i] + 1;
+  }
+
+  Result->Failed = !Loaded;
+  Result->Rejected = NotAudio;
+  Result->Gone = !Loaded && (Job->Kind == IMPORT_VALIDATE || Job->Kind == IMPORT_CHANGED) && SA_FileGone(Job->Path);
+  Result->Kind = Job->Kind;
+  Result->Duration = l_Tags.Duration;
+  Result->MTime = MTime;
+  Result->Size = FileSize;
+  Result->Hash = Hash;
+  Result->Ordinal = Job->Ordinal;
+  Result->Play = Job->Play;
+  Result->Generation = Job->Generation;
+  Result->Category = Job->Category;
+  Result->Title = Offsets[1];
+  Result->Artist = Offsets[2];
+  Result->Album = Offsets[3];
+  Result->Copyright = Offsets[4];
+
+  return Result;
+}
+
+/* Appends Job to a chain built up before a single PushJobs call. */
+static void ChainJob(ImportJob **First, ImportJob **Last, ImportJob *Job) {
+  if (*Last)
+    (*Last)->Next = Job;
+  else
+    *First = Job;
+
+  *Last = Job;
+}
+
+#ifndef WINDOWS
+typedef struct {
+  uint64_t Inode;
+  ImportJob *Job;
+} ScanEntry;
+
+static int CompareInodes(const void *A, const void *B) {
+  uint64_t InodeA = ((const ScanEntry *)A)->Inode, InodeB = ((const ScanEntry *)B)->Inode;
+  return InodeA < InodeB ? -1 : InodeA > InodeB;
+}
+#endif
+
+/*
+ * Lists one directory. Subdirectories become directory jobs of their own, so a tree is walked by
+ * every worker at once. Files are queued in inode order, which is close to their on-disk order
+ * and keeps spinning disks and network mounts from seeking back and forth. A rescan only probes
+ * the files it finds, and they don't count towards the import progress.
+ */
+static void ReadDirectory(ImportJob *Job) {
+  ImportJob *Directories = NULL, *LastDirectory = NULL;
+  uint32_t DirectoryCount = 0;
+  uint8_t FileKind = Job->Kind == IMPORT_RESCAN ? IMPORT_PROBE : IMPORT_FILE;
+  size_t PathLen = strlen(Job->Path);
+
+  while (PathLen > 1 && (Job->Path[PathLen - 1] == '/' || Job->Path[PathLen - 1] == '\\'))
+    PathLen--;
+
+  #ifndef WINDOWS
+  ScanEntry *Files = NULL;
+  uint32_t FileCount = 0, FileCapacity = 0;
+  char FullPath[PATH_MAX];
+  struct dirent *Entry;
+
+  int Descriptor = open(Job->Path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  DIR *Directory = Descriptor == -1 ? NULL : fdopendir(Descriptor);
+
+  if (!Directory) {
+    SDL_Log("Unable to open directory %s.", Job->Path);
+
+    if (Descriptor != -1)
+      close(Descriptor);
+
+    return;
+  }
+
+  memcpy(FullPath, Job->Path, PathLen);
+  FullPath[PathLen] = '/';
+
+  while ((Entry = readdir(Directory)) != NULL) {
+    if (Cancelled(Job->Generation))
+      break;
+
+    const char *Name = Entry->d_name;
+    size_t NameLen = strlen(Name);
+
+    /* Not interested into those directories, nor hidden files; the watcher skips them too. */
+    if (Name[0] == '.')
+      continue;
+
+    if (PathLen + NameLen + 2 > sizeof(FullPath))
+      continue;
+
+    /* d_type saves a stat per entry, except on filesystems that don't fill it in and for links.
+     * Linked directories are not followed, they are the usual way to build a loop. */
+    uint8_t Type = Entry->d_type;
+
+    if (Type == DT_UNKNOWN || Type == DT_LNK) {
+      struct stat Stats;
+
+      if (fstatat(dirfd(Directory), Name, &Stats, 0) == -1) {
+        SDL_Log("stat() failed on %s.", Name);
+        continue;
+      }
+
+      Type = S_ISREG(Stats.st_mode) ? DT_REG : (S_ISDIR(Stats.st_mode) && Type == DT_UNKNOWN) ? DT_DIR : DT_UNKNOWN;
+    }
+
+    if (Type != DT_REG && Type != DT_DIR)
+      continue;
+
+    memcpy(FullPath + PathLen + 1, Name, NameLen + 1);
+
+    if (Type == DT_DIR) {
+      ChainJob(&Directories, &LastDirectory, NewJob(FullPath, Job->Category, Job->Kind, Job->Generation, 0, 0));
+      DirectoryCount++;
+      continue;
+    }
+
+    if (FileCount == FileCapacity) {
+      FileCapacity = FileCapacity ? FileCapacity * 2 : 64;
+      ScanEntry *l_Files = realloc(Files, sizeof(ScanEntry) * FileCapacity);
+
+      if (!l_Files) {
+        SDL_Log("[FATAL]: Unable to realloc the directory listing.\n");
+        exit(EXIT_FAILURE);
+      }
+
+      Files = l_Files;
+    }
+
+    Files[FileCount++] = (ScanEntry){Entry->d_ino, NewJob(FullPath, Job->Category, FileKind, Job->Generation, 0, 0)};
+  }
+
+  closedir(Directory);
+
+  if (FileCount) {
+    qsort(Files, FileCount, sizeof(ScanEntry), CompareInodes);
+
+    for (uint32_t i = 1; i < FileCount; i++)
+      Files[i - 1].Job->Next = Files[i].Job;
+
+    if (FileKind == IMPORT_FILE)
+      SDL_AddAtomicInt(&Total, FileCount);
+
+    PushJobs(Files[0].Job, Files[FileCount - 1].Job, FileCount);
+  }
+
+  free(Files);
+  #else
+  ImportJob *Files = NULL, *LastFile = NULL;
+  uint32_t FileCount = 0;
+  char FullPath[MAX_PATH];
+  HANDLE HandleFind = INVALID_HANDLE_VALUE;
+  WIN32_FIND_DATA FileData;
+
+  if (PathLen + 3 > MAX_PATH)
+    return;
+
+  memcpy(FullPath, Job->Path, PathLen);
+  memcpy(FullPath + PathLen, "\\*", 3);
+
+  HandleFind = FindFirstFile(FullPath, &FileData);
+
+  if (HandleFind == INVALID_HANDLE_VALUE) {
+    SDL_Log("INVALID_HANDLE_VALUE returned by FindFirstFile.");
+    return;
+  }
+
+  do {
+    if (Cancelled(Job->Generation))
+      break;
+
+    const char *Name = FileData.cFileName;
+    size_t NameLen = strlen(Name);
+
+    /* Hidden entries and reparse points (junctions can loop) are skipped */
+    if (Name[0] == '.' || (FileData.dwFileAttributes & (FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_REPARSE_POINT)) ||
+        PathLen + NameLen + 2 > MAX_PATH)
+      continue;
+
+    memcpy(FullPath + PathLen + 1, Name, NameLen + 1);
+
+    if (FileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+      ChainJob(&Directories, &LastDirectory, NewJob(FullPath, Job->Category, Job->Kind, Job->Generation, 0, 0));
+      DirectoryCount++;
+    } else {
+      ChainJob(&Files, &LastFile, NewJob(FullPath, Job->Category, FileKind, Job->Generation, 0, 0));
+      FileCount++;
+    }
+  } while (FindNextFile(HandleFind, &FileData) != 0);
+
+  FindClose(HandleFind);
+
+  if (FileCount) {
+    if (FileKind == IMPORT_FILE)
+      SDL_AddAtomicInt(&Total, FileCount);
+
+    PushJobs(Files, LastFile, FileCount);
+  }
+  #endif
+
+  if (DirectoryCount)
+    PushJobs(Directories, LastDirectory, DirectoryCount);
+}
+
+/* The main thread drains the ring every frame, a full ring only means a slow frame */
+static void PushResult(ImportResult *Result) {
+  while (!RingPush(Result)) {
+    if (Quit) {
+      free(Result);
+      break;
+    }
+
+    SDL_Delay(1);
+  }
+}
+
+typedef struct {
+  ImportJob *Job;
+  uint64_t Ordinal;
+} PlaylistCursor;
+
+/* Entries go back to the main thread in playlist order, which knows whether they are in the
+ * library already. */
+static void PushEntry(const char *Path, void *Data) {
+  PlaylistCursor *Cursor = Data;
+  ImportJob *Entry = NewJob(Path, Cursor->Job->Category, IMPORT_ENTRY, Cursor->Job->Generation, 0, 0);
+
+  Entry->Ordinal = Cursor->Ordinal++;
+  SDL_AddAtomicInt(&Pending, 1);
+  PushResult(ReadTrack(Entry));
+  free(Entry);
+}
+
+/* Reads one chunk. If there is more, a result follows its entries and the main thread queues the
+ * next chunk once it gets there, behind the file jobs the entries led to. The reader never gets
+ * more than a chunk ahead of the workers, so the job list stays short however long the playlist is.
+ * Returns whether that result was pushed, it then stands for the job in Pending. */
+static bool ReadPlaylist(ImportJob *Job) {
+  uint64_t Offset = Job->Size;
+  PlaylistCursor Cursor = {Job, Job->Ordinal};
+
+  if (!SA_PlaylistRead(Job->Path, &Offset, PLAYLIST_CHUNK, PushEntry, &Cursor))
+    return false;
+
+  if (Cancelled(Job->Generation))
+    return false;
+
+  Job->Ordinal = Cursor.Ordinal;
+
+  ImportResult *Result = ReadTrack(Job);
+
+  Result->Size = Offset;
+  PushResult(Result);
+  return true;
+}
+
+static int ImportWorker(void *Data) {
+  (void)Data;
+
+  for (;;) {
+    SDL_LockMutex(JobLock);
+
+    while (!JobHead && !Quit)
+      SDL_WaitCondition(JobReady, JobLock);
+
+    if (Quit) {
+      SDL_UnlockMutex(JobLock);
+      return 0;
+    }
+
+    ImportJob *Job = JobHead;
+    JobHead = Job->Next;
+
+    if (!JobHead)
+      JobTail = NULL;
+
+    SDL_UnlockMutex(JobLock);
+
+    int64_t MTime;
+    uint64_t Size;
+
+    if (Cancelled(Job->Generation)) {
+      SDL_AddAtomicInt(&Pending, -1);
+    } else if (Job->Kind == IMPORT_DIRECTORY || Job->Kind == IMPORT_RESCAN) {
+      ReadDirectory(Job);
+      SDL_AddAtomicInt(&Pending, -1);
+    } else if (Job->Kind == IMPORT_PLAYLIST) {
+      if (!ReadPlaylist(Job))
+        SDL_AddAtomicInt(&Pending, -1);
+    } else if ((Job->Kind == IMPORT_VALIDATE || Job->Kind == IMPORT_CHANGED) && SA_FileStamp(Job->Path, &MTime, &Size) && MTime == Job->MTime && Size == Job->Size) {
+      SDL_AddAtomicInt(&Pending, -1);
+    } else {
+      PushResult(ReadTrack(Job));
+    }
+
+    free(Job);
+  }
+}
+
+void InitializeImport() {
+  JobLock = SDL_CreateMutex();
+  JobReady = SDL_CreateCondition();
+
+  if (!JobLock || !JobReady) {
+    SDL_Log("[FATAL]: Unable to create the import lock: %s\n", SDL_GetError());
+    exit(EXIT_FAILURE);
+  }
+
+  for (uint32_t i = 0; i < IMPORT_RING_SIZE; i++)
+    SDL_SetAtomicInt(&Ring[i].Sequence, i);
+
+  /* Leave a core to the UI and the mixer */
+  WorkerCount = SDL_GetNumLogicalCPUCores() - 1;
+  WorkerCount = WorkerCount < 1 ? 1 : WorkerCount > IMPORT_MAX_WORKERS ? IMPORT_MAX_WORKERS : WorkerCount;
+
+  for (int i = 0; i < WorkerCount; i++) {
+    Workers[i] = SDL_CreateThread(ImportWorker, "SA_Import", NULL);
+
+    if (!Workers[i]) {
+      SDL_Log("[FATAL]: Unable to create an import thread: %s\n", SDL_GetError());
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+void ShutdownImport() {
+  SDL_LockMutex(JobLock);
+  Quit = true;
+  SDL_BroadcastCondition(JobReady);
+  SDL_UnlockMutex(JobLock);
+
+  for (int i = 0; i < WorkerCount; i++)
+    SDL_WaitThread(Workers[i], NULL);
+
+  while (JobHead) {
+    ImportJob *Next = JobHead->Next;
+    free(JobHead);
+    JobHead = Next;
+  }
+
+  for (ImportResult *Result; (Result = RingPop()) != NULL;)
+    free(Result);
+
+  SDL_DestroyCondition(JobReady);
+  SDL_DestroyMutex(JobLock);
+}
+
+void SA_ImportFile(const char *Path, uint8_t Category) {
+  if (GetAudioIndex(Path) != -1) {
+    SDL_Log("\"%s\" is already loaded.", Path);
+    return;
+  }
+
+  PushJob(Path, Category, IMPORT_FILE, SDL_GetAtomicInt(&Generation));
+}
+
+/* Plays Path, importing it first if the library doesn't have it yet. Its tags and hash are read on
+ * a worker like any other file's, and it starts playing once it lands. */
+void SA_ImportPlay(const char *Path, uint8_t Category) {
+  if (GetAudioIndex(Path) != -1) {
+    PlayAudio(Path);
+    return;
+  }
+
+  ImportJob *Job = NewJob(Path, Category, IMPORT_FILE, SDL_GetAtomicInt(&Generation), 0, 0);
+
+  Job->Play = true;
+  SDL_AddAtomicInt(&Total, 1);
+  PushJobs(Job, Job, 1);
+}
+
+void SA_ImportDirectory(const char *Path, uint8_t Category) {
+  PushJob(Path, Category, IMPORT_DIRECTORY, SDL_GetAtomicInt(&Generation));
+}
+
+/* Checks every track against the stamp its tags were read at, as one batch. Unchanged files never
+ * come back to the main thread; changed ones are updated in place and missing ones removed. Tracks
+ * never read for a duration are read again. Ones already found to have no readable length, or no
+ * hash, wait for their stamp to change like the rest. */
+void SA_ImportValidateLibrary() {
+  ImportJob *First = NULL, *Last = NULL;
+  uint32_t Count = 0;
+
+  for (uint32_t i = 0; i < SA_TotalAudio; i++) {
+    if (Audio[i].Path == 0)
+      continue;
+
+    int64_t MTime;
+    uint64_t Size;
+
+    SA_CacheGetStamp(i, &MTime, &Size);
+
+    if (Audio[i].Duration == 0)
+      MTime = Size = 0;
+
+    ImportJob *Job = NewJob(SA_String(Audio[i].Path), 0, IMPORT_VALIDATE, IMPORT_BACKGROUND, MTime, Size);
+
+    if (Last)
+      Last->Next = Job;
+    else
+      First = Job;
+
+    Last = Job;
+    Count++;
+  }
+
+  if (Count)
+    PushJobs(First, Last, Count);
+}
+
+/* For the watcher: Path was created, written to or deleted. Only the main thread knows the stamp a
+ * tracked file was read at, so it is looked up here and the worker skips the file if it matches. */
+void SA_ImportChanged(const char *Path, uint8_t Category) {
+  int32_t Index = GetAudioIndex(Path);
+  int64_t MTime = 0;
+  uint64_t Size = 0;
+
+  if (Index != -1)
+    SA_CacheGetStamp(Index, &MTime, &Size);
+
+  ImportJob *Job = NewJob(Path, Category, IMPORT_CHANGED, IMPORT_BACKGROUND, MTime, Size);
+  PushJobs(Job, Job, 1);
+}
+
+/* Ordinal is the base the entries are numbered from, see SA_PlaylistImport(). */
+void SA_ImportPlaylist(const char *Path, uint8_t Category, uint64_t Ordinal) {
+  ImportJob *Job = NewJob(Path, Category, IMPORT_PLAYLIST, SDL_GetAtomicInt(&Generation), 0, 0);
+
+  Job->Ordinal = Ordinal + 1;
+  PushJobs(Job, Job, 1);
+}
+
+/* Walks Path in the background and adds the files the library is missing, without showing an
+ * import. Tracks already known are left to SA_ImportValidateLibrary(). */
+void SA_ImportRescan(const char *Path, uint8_t Category) {
+  PushJob(Path, Category, IMPORT_RESCAN, IMPORT_BACKGROUND);
+}
+
+bool SA_ImportIdle() {
+  return SDL_GetAtomicInt(&Pending) == 0;
+}
+
+/* Queued jobs are freed right away; whatever a worker is busy with is dropped when it comes back.
+ * Background jobs stay queued in order. */
+void SA_ImportCancel() {
+  SDL_LockMutex(JobLock);
+  SDL_AddAtomicInt(&Generation, 1);
+
+  ImportJob *Job = JobHead, *Kept = NULL;
+  JobHead = NULL;
+
+  while (Job) {
+    ImportJob *Next = Job->Next;
+
+    if (Job->Generation == IMPORT_BACKGROUND) {
+      Job->Next = NULL;
+
+      if (Kept)
+        Kept->Next = Job;
+      else
+        JobHead = Job;
+
+      Kept = Job;
+    } else {
+      free(Job);
+      SDL_AddAtomicInt(&Pending, -1);
+    }
+
+    Job = Next;
+  }
+
+  JobTail = Kept;
+  SDL_UnlockMutex(JobLock);
+
+  SDL_Log("Import cancelled after %u of %u files.", Done, (uint32_t)SDL_GetAtomicInt(&Total));
+}
+
+/* A new file whose content the library already has is not added, the track already there stands
+ * for it. If that track's file is gone, the file was moved or renamed (the watcher reports the new
+ * path first as often as not), so the track follows it instead. Returns that track, or -1. */
+static int32_t DuplicateOf(const ImportResult *Result) {
+  int32_t Duplicate = SA_ContentFind(Result->Hash, -1);
+  int64_t MTime;
+  uint64_t Size;
+
+  if (Duplicate == -1)
+    return -1;
+
+  if (SA_FileStamp(SA_String(Audio[Duplicate].Path), &MTime, &Size)) {
+    SDL_Log("\"%s\" is a duplicate of \"%s\", skipped.", Result->Strings, SA_String(Audio[Duplicate].Path));
+  } else {
+    SDL_Log("\"%s\" moved to \"%s\".", SA_String(Audio[Duplicate].Path), Result->Strings);
+    RenameAudio(Duplicate, Result->Strings);
+    SA_CacheStamp(Duplicate, Result->MTime, Result->Size);
+  }
+
+  return Duplicate;
+}
+
+/* A track already in the library that turns out to be a copy of another one is kept, only flagged:
+ * which of the two paths to drop is the user's call. */
+static void SetHash(uint32_t Index, uint64_t Hash) {
+  SA_ContentSet(Index, Hash);
+
+  int32_t Duplicate = SA_ContentFind(Hash, Index);
+
+  if (Duplicate != -1)
+    SDL_Log("\"%s\" has the same content as \"%s\".", SA_String(Audio[Index].Path), SA_String(Audio[Duplicate].Path));
+}
+
+void SA_ImportPoll() {
+  uint64_t Start = SDL_GetTicksNS();
+  ImportResult *Result;
+
+  if (!Batching && SDL_GetAtomicInt(&Pending) != 0) {
+    SA_BeginAudioBatch();
+    Batching = true;
+    LastRefresh = Start;
+  }
+
+  while ((Result = RingPop()) != NULL) {
+    const char *Strings = Result->Strings;
+
+    if (Cancelled(Result->Generation)) {
+      /* Cancelled */
+    } else if (Result->Kind == IMPORT_VALIDATE) {
+      int32_t Index = GetAudioIndex(Strings);
+
+      if (Index == -1) {
+        /* Removed while it was being checked */
+      } else if (Result->Gone) {
+        AudioRemove(Index);
+        Missing++;
+      } else if (Result->Failed) {
+        /* Unreadable or unmounted for now, kept with its old stamp so it is tried again */
+      } else {
+        UpdateAudio(Index, Strings + Result->Title, Strings + Result->Artist, Strings + Result->Album, Strings + Result->Copyright);
+        SA_CacheStamp(Index, Result->MTime, Result->Size);
+        SetHash(Index, Result->Hash);
+        Changed++;
+
+        Audio[Index].Duration = SA_KnownDuration(Result->Duration);
+      }
+    } else if (Result->Kind == IMPORT_CHANGED) {
+      int32_t Index = GetAudioIndex(Strings);
+
+      if (Result->Gone || Result->Rejected) {
+        if (Index != -1) {
+          AudioRemove(Index);
+          Missing++;
+        }
+      } else if (Result->Failed) {
+        /* Still there but unreadable, a track already known keeps its record */
+      } else if (Index != -1) {
+        UpdateAudio(Index, Strings + Result->Title, Strings + Result->Artist, Strings + Result->Album, Strings + Result->Copyright);
+        SA_CacheStamp(Index, Result->MTime, Result->Size);
+        SetHash(Index, Result->Hash);
+        Changed++;
+
+        Audio[Index].Duration = SA_KnownDuration(Result->Duration);
+      } else if (DuplicateOf(Result) != -1) {
+        /* Already in the library under another path */
+      } else {
+        Index = InsertAudio(Strings, Strings + Result->Title, Strings + Result->Artist, Strings + Result->Album,
+                            Strings + Result->Copyright, SA_String(Categories[Result->Category].Name));
+
+        if (Index != -1) {
+          SA_CacheStamp(Index, Result->MTime, Result->Size);
+          SA_ContentSet(Index, Result->Hash);
+          Audio[Index].Duration = SA_KnownDuration(Result->Duration);
+          Added++;
+        }
+      }
+    } else if (Result->Kind == IMPORT_ENTRY) {
+      int32_t Index = GetAudioIndex(Strings);
+
+      if (Index != -1) {
+        MoveAudio(Index, Result->Category);
+        SA_PlaylistPlace(Index, Result->Ordinal);
+      } else {
+        /* Queued before this result is accounted for, as for probes */
+        ImportJob *Job = NewJob(Strings, Result->Category, IMPORT_FILE, Result->Generation, 0, 0);
+
+        Job->Ordinal = Result->Ordinal;
+        SDL_AddAtomicInt(&Total, 1);
+        PushJobs(Job, Job, 1);
+      }
+    } else if (Result->Kind == IMPORT_PLAYLIST) {
+      /* Every entry of the chunk is handled, read on from where it stopped */
+      ImportJob *Job = NewJob(Strings, Result->Category, IMPORT_PLAYLIST, Result->Generation, 0, Result->Size);
+
+      Job->Ordinal = Result->Ordinal;
+      PushJobs(Job, Job, 1);
+    } else if (Result->Kind == IMPORT_PROBE) {
+      /* Queued before this result is accounted for, so Pending can't reach 0 in between */
+      if (GetAudioIndex(Strings) == -1)
+        SA_ImportChanged(Strings, Result->Category);
+    } else {
+      int32_t Duplicate = Result->Failed ? -1 : DuplicateOf(Result);
+      int32_t Index = Result->Failed || Duplicate != -1 ? -1 : InsertAudio(Strings, Strings + Result->Title, Strings + Result->Artist,
+                                                                           Strings + Result->Album, Strings + Result->Copyright,
+                                                                           SA_String(Categories[Result->Category].Name));
+
+      if (Result->Rejected) {
+        Rejected++;
+      } else if (Duplicate != -1) {
+        Duplicates++;
+
+        /* A playlist still gets the copy already in the library */
+        if (Result->Ordinal) {
+          MoveAudio(Duplicate, Result->Category);
+          SA_PlaylistPlace(Duplicate, Result->Ordinal);
+        }
+      } else if (Index == -1) {
+        Failed++;
+      } else {
+        SA_CacheStamp(Index, Result->MTime, Result->Size);
+        SA_ContentSet(Index, Result->Hash);
+        Audio[Index].Duration = SA_KnownDuration(Result->Duration);
+
+        if (Result->Ordinal)
+          SA_PlaylistPlace(Index, Result->Ordinal);
+      }
+
+      /* A duplicate plays the copy already in the library */
+      if (Result->Play && (Index != -1 || Duplicate != -1))
+        PlayAudio(SA_String(Audio[Index != -1 ? Index : Duplicate].Path));
+
+      Done++;
+    }
+
+    free(Result);
+    SDL_AddAtomicInt(&Pending, -1);
+
+    if (SDL_GetTicksNS() - Start > IMPORT_POLL_BUDGET_NS)
+      break;
+  }
+
+  bool Finished = SDL_GetAtomicInt(&Pending) == 0;
+
+  /* A visible import shows its progress by committing every IMPORT_REFRESH_NS. Background work
+   * (cache checks, watcher batches) commits before the frame ends: it may run for minutes, and
+   * changes the user makes meanwhile must refresh the playlist right away. */
+  if (Batching && (Finished || SDL_GetAtomicInt(&Total) == 0)) {
+    SA_CommitAudioBatch();
+    Batching = false;
+  } else if (Batching && SDL_GetAtomicInt(&Total) != 0 && SDL_GetTicksNS() - LastRefresh > IMPORT_REFRESH_NS) {
+    SA_CommitAudioBatch();
+    SA_BeginAudioBatch();
+    LastRefresh = SDL_GetTicksNS();
+  }
+
+  if (Finished && SDL_GetAtomicInt(&Total) != 0) {
+    SDL_Log("Imported %u files, %u skipped, %u not audio, %u duplicates.", Done - Failed - Rejected - Duplicates, Failed,
+            Rejected, Duplicates);
+
+    SDL_SetAtomicInt(&Total, 0);
+    Done = Failed = Rejected = Duplicates = 0;
+  }
+
+  if (Finished && (Added || Changed || Missing)) {
+    SDL_Log("Library check: %u tracks added, %u re-read, %u missing ones removed.", Added, Changed, Missing);
+    Added = Changed = Missing = 0;
+  }
+}
+
+/* Returns whether an import is running, with the number of files handled so far. Background checks
+ * of cached tracks don't count. */
+bool SA_ImportProgress(uint32_t *l_Done, uint32_t *l_Total) {
+  *l_Done = Done;
+  *l_Total = SDL_GetAtomicInt(&Total);
+
+  return SDL_GetAtomicInt(&Pending) != 0 && *l_Total != 0;
+}
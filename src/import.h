@@ -0,0 +1,29 @@
+#ifndef __SAIMPORT__
+#define __SAIMPORT__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Library import off the UI thread. Jobs are handed to a pool of worker threads which open the
+ * files and read their tags; finished tracks come back through a lock-free ring that the main loop
+ * drains with SA_ImportPoll(). Only the main thread ever touches the library itself.
+ */
+#define IMPORT_MAX_WORKERS 8
+#define IMPORT_RING_SIZE   1024 /* Power of two */
+
+void InitializeImport();
+void ShutdownImport();
+void SA_ImportFile(const char *Path, uint8_t Category);
+void SA_ImportPlay(const char *Path, uint8_t Category);
+void SA_ImportDirectory(const char *Path, uint8_t Category);
+void SA_ImportValidateLibrary();
+void SA_ImportChanged(const char *Path, uint8_t Category);
+void SA_ImportRescan(const char *Path, uint8_t Category);
+void SA_ImportPlaylist(const char *Path, uint8_t Category, uint64_t Ordinal);
+bool SA_ImportIdle();
+void SA_ImportCancel();
+void SA_ImportPoll();
+bool SA_ImportProgress(uint32_t *Done, uint32_t *Total);
+
+#endif
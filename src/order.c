@@ -0,0 +1,171 @@
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+
+#include "order.h"
+
+typedef struct {
+  uint32_t Left, Right, Parent;
+  uint32_t Size, Priority;
+} OrderNode;
+
+static OrderNode *Nodes;
+static uint32_t NodeCapacity;
+static uint32_t RandomState = 0x9e3779b9;
+
+static uint32_t NextPriority() {
+  /* xorshift32, treap priorities only need to be well spread */
+  RandomState ^= RandomState << 13;
+  RandomState ^= RandomState >> 17;
+  RandomState ^= RandomState << 5;
+  return RandomState;
+}
+
+void SA_OrderResize(uint32_t Capacity) {
+  if (Capacity <= NodeCapacity)
+    return;
+
+  OrderNode *l_Nodes = realloc(Nodes, sizeof(OrderNode) * Capacity);
+
+  if (!l_Nodes) {
+    SDL_Log("[FATAL]: Unable to realloc order nodes.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  Nodes = l_Nodes;
+  NodeCapacity = Capacity;
+}
+
+uint32_t SA_OrderSize(uint32_t Root) {
+  return Root == ORDER_NIL ? 0 : Nodes[Root].Size;
+}
+
+static void Update(uint32_t Node) {
+  OrderNode *l_Node = &Nodes[Node];
+  l_Node->Size = 1 + SA_OrderSize(l_Node->Left) + SA_OrderSize(l_Node->Right);
+
+  if (l_Node->Left != ORDER_NIL)
+    Nodes[l_Node->Left].Parent = Node;
+
+  if (l_Node->Right != ORDER_NIL)
+    Nodes[l_Node->Right].Parent = Node;
+}
+
+static uint32_t Merge(uint32_t A, uint32_t B) {
+  if (A == ORDER_NIL)
+    return B;
+
+  if (B == ORDER_NIL)
+    return A;
+
+  if (Nodes[A].Priority > Nodes[B].Priority) {
+    Nodes[A].Right = Merge(Nodes[A].Right, B);
+    Update(A);
+    return A;
+  }
+
+  Nodes[B].Left = Merge(A, Nodes[B].Left);
+  Update(B);
+  return B;
+}
+
+/* Splits Root so that the first Count nodes end up in Left and the rest in Right. */
+static void Split(uint32_t Root, uint32_t Count, uint32_t *Left, uint32_t *Right) {
+  if (Root == ORDER_NIL) {
+    *Left = *Right = ORDER_NIL;
+    return;
+  }
+
+  uint32_t LeftSize = SA_OrderSize(Nodes[Root].Left);
+
+  if (Count <= LeftSize) {
+    Split(Nodes[Root].Left, Count, Left, &Nodes[Root].Left);
+    *Right = Root;
+  } else {
+    Split(Nodes[Root].Right, Count - LeftSize - 1, &Nodes[Root].Right, Right);
+    *Left = Root;
+  }
+
+  Update(Root);
+}
+
+static uint32_t SetRoot(uint32_t Root) {
+  if (Root != ORDER_NIL)
+    Nodes[Root].Parent = ORDER_NIL;
+
+  return Root;
+}
+
+uint32_t SA_OrderAt(uint32_t Root, uint32_t Position) {
+  if (Position >= SA_OrderSize(Root))
+    return ORDER_NIL;
+
+  while (Root != ORDER_NIL) {
+    uint32_t LeftSize = SA_OrderSize(Nodes[Root].Left);
+
+    if (Position == LeftSize)
+      return Root;
+
+    if (Position < LeftSize) {
+      Root = Nodes[Root].Left;
+    } else {
+      Position -= LeftSize + 1;
+      Root = Nodes[Root].Right;
+    }
+  }
+
+  return ORDER_NIL;
+}
+
+uint32_t SA_OrderPosition(uint32_t Node) {
+  uint32_t Position = SA_OrderSize(Nodes[Node].Left);
+
+  for (uint32_t Parent = Nodes[Node].Parent; Parent != ORDER_NIL; Node = Parent, Parent = Nodes[Node].Parent) {
+    if (Nodes[Parent].Right == Node)
+      Position += SA_OrderSize(Nodes[Parent].Left) + 1;
+  }
+
+  return Position;
+}
+
+uint32_t SA_OrderFirst(uint32_t Root) {
+  if (Root == ORDER_NIL)
+    return ORDER_NIL;
+
+  while (Nodes[Root].Left != ORDER_NIL)
+    Root = Nodes[Root].Left;
+
+  return Root;
+}
+
+/* In-order successor. Walking a whole tree this way costs O(1) amortized per step. */
+uint32_t SA_OrderNext(uint32_t Node) {
+  if (Nodes[Node].Right != ORDER_NIL)
+    return SA_OrderFirst(Nodes[Node].Right);
+
+  uint32_t Parent = Nodes[Node].Parent;
+
+  while (Parent != ORDER_NIL && Nodes[Parent].Right == Node) {
+    Node = Parent;
+    Parent = Nodes[Node].Parent;
+  }
+
+  return Parent;
+}
+
+uint32_t SA_OrderInsert(uint32_t Root, uint32_t Node, uint32_t Position) {
+  uint32_t Left, Right;
+
+  Nodes[Node] = (OrderNode){ORDER_NIL, ORDER_NIL, ORDER_NIL, 1, NextPriority()};
+  Split(Root, Position, &Left, &Right);
+
+  return SetRoot(Merge(Merge(Left, Node), Right));
+}
+
+uint32_t SA_OrderErase(uint32_t Root, uint32_t Node) {
+  uint32_t Left, Middle, Right;
+
+  Split(Root, SA_OrderPosition(Node), &Left, &Right);
+  Split(Right, 1, &Middle, &Right);
+
+  return SetRoot(Merge(Left, Right));
+}
@@ -0,0 +1,23 @@
+#ifndef __SAORDER__
+#define __SAORDER__
+
+#include <stdint.h>
+
+/*
+ * Implicit treap over library indices: every track is one node, and each category's tracks form
+ * one tree ordered by layout position. Lookup by position, position of a track, insertion at any
+ * position and removal are all O(log n). Nodes keep parent links so a track's position can be
+ * found without knowing where it is.
+ */
+#define ORDER_NIL UINT32_MAX
+
+void SA_OrderResize(uint32_t Capacity);
+uint32_t SA_OrderSize(uint32_t Root);
+uint32_t SA_OrderAt(uint32_t Root, uint32_t Position);
+uint32_t SA_OrderPosition(uint32_t Node);
+uint32_t SA_OrderFirst(uint32_t Root);
+uint32_t SA_OrderNext(uint32_t Node);
+uint32_t SA_OrderInsert(uint32_t Root, uint32_t Node, uint32_t Position);
+uint32_t SA_OrderErase(uint32_t Root, uint32_t Node);
+
+#endif
@@ -13,7 +13,9 @@
 char ResultBuffer[PATH_MAX];
 
 const char *OpenDialogue(enum DialogueOption Option) {
-  FILE *FilePointer = popen(Option == PFD_DIRECTORY ? "zenity --file-selection --directory" : "zenity --file-selection", "r");
+  const char *Command = Option == PFD_DIRECTORY ? "zenity --file-selection --directory" :
+                        Option == PFD_SAVE ? "zenity --file-selection --save --confirm-overwrite" : "zenity --file-selection";
+  FILE *FilePointer = popen(Command, "r");
   
   if (!FilePointer) {
     printf("error: %s\n", strerror(errno));
@@ -116,6 +118,12 @@ const char *OpenDialogue(enum DialogueOption Option) {
     }
     
     return Status == TRUE ? ResultBuffer : NULL;
+  } else if (Option == PFD_SAVE) {
+    OPENFILENAME OFN;
+    PopulateOFN(&OFN);
+    OFN.Flags = OFN_OVERWRITEPROMPT;
+
+    return GetSaveFileName(&OFN) == TRUE ? OFN.lpstrFile : NULL;
   } else {
     OPENFILENAME OFN;
     PopulateOFN(&OFN);
@@ -5,7 +5,8 @@
 
 enum DialogueOption {
   PFD_DIRECTORY,
-  PFD_FILE
+  PFD_FILE,
+  PFD_SAVE
 };
 
 const char *OpenDialogue(enum DialogueOption Option);
@@ -0,0 +1,446 @@
+#include <SDL3/SDL.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "audio.h"
+#include "category.h"
+#include "import.h"
+#include "order.h"
+#include "playlist.h"
+#include "queue.h"
+
+#ifndef WINDOWS
+#define PLAYLIST_PATH_MAX PATH_MAX
+#define SEPARATOR         '/'
+#define FOREIGN_SEPARATOR '\\'
+#else
+#define PLAYLIST_PATH_MAX MAX_PATH
+#define SEPARATOR         '\\'
+#define FOREIGN_SEPARATOR '/'
+#endif
+
+typedef struct {
+  SDL_IOStream *IO;
+  char *Buffer;
+  size_t Used;
+  bool Failed;
+} PlaylistWriter;
+
+/* Position of each track in the playlist that put it in its category, 0 for the rest. The high
+ * half is the import it came from, so a later import of the same playlist sorts after. */
+static uint64_t *Ordinals;
+static uint32_t OrdinalCapacity;
+static uint32_t ImportSerial;
+
+/* Every placed track sorted by ordinal, apart from the category layout the user may rearrange. An
+ * entry whose track was removed or placed again no longer matches Ordinals and is skipped. */
+typedef struct {
+  uint64_t Ordinal;
+  uint32_t Index;
+} PlacedEntry;
+
+static PlacedEntry *Placed;
+static uint32_t PlacedCount, PlacedCapacity;
+
+static bool IsPLS(const char *Path) {
+  const char *Dot = strrchr(Path, '.');
+  return Dot && SDL_strcasecmp(Dot + 1, "pls") == 0;
+}
+
+bool SA_IsPlaylist(const char *Path) {
+  const char *Dot = strrchr(Path, '.');
+
+  if (!Dot || strchr(Dot, '/') || strchr(Dot, '\\'))
+    return false;
+
+  return SDL_strcasecmp(Dot + 1, "m3u") == 0 || SDL_strcasecmp(Dot + 1, "m3u8") == 0 || SDL_strcasecmp(Dot + 1, "pls") == 0;
+}
+
+/* The category is named after the playlist file, without its extension. */
+void SA_PlaylistImport(const char *Path) {
+  const char *Name = Path;
+  char CategoryName[128];
+
+  for (const char *Cursor = Path; *Cursor; Cursor++) {
+    if (*Cursor == '/' || *Cursor == '\\')
+      Name = Cursor + 1;
+  }
+
+  const char *Dot = strrchr(Name, '.');
+  size_t Length = Dot && Dot != Name ? (size_t)(Dot - Name) : strlen(Name);
+
+  if (Length >= sizeof(CategoryName))
+    Length = sizeof(CategoryName) - 1;
+
+  memcpy(CategoryName, Name, Length);
+  CategoryName[Length] = '\0';
+
+  int32_t Category = SA_CreateCategory(CategoryName[0] ? CategoryName : "Playlist");
+
+  if (Category == -1) {
+    SDL_Log("No room for category \"%s\", importing \"%s\" into All.", CategoryName, Path);
+    Category = 0;
+  }
+
+  SA_ImportPlaylist(Path, Category, (uint64_t)++ImportSerial << 32);
+}
+
+static int HexDigit(char Character) {
+  if (Character >= '0' && Character <= '9')
+    return Character - '0';
+
+  Character |= 0x20;
+  return Character >= 'a' && Character <= 'f' ? Character - 'a' + 10 : -1;
+}
+
+/*
+ * Turns one line into a path, or returns false for comments, PLS keys other than FileN, and
+ * streams. file:// URLs are decoded, separators are made native, and relative entries are resolved
+ * against the playlist's directory (the first DirectoryLength bytes of Playlist).
+ */
+static bool ParseLine(char *Line, bool PLS, const char *Playlist, size_t DirectoryLength, char *Out) {
+  size_t Length = strlen(Line);
+
+  while (Length > 0 && (Line[Length - 1] == '\r' || Line[Length - 1] == ' ' || Line[Length - 1] == '\t'))
+    Line[--Length] = '\0';
+
+  while (*Line == ' ' || *Line == '\t')
+    Line++;
+
+  if (PLS) {
+    if (SDL_strncasecmp(Line, "file", 4) != 0 || Line[4] < '0' || Line[4] > '9')
+      return false;
+
+    Line += 4;
+
+    while (*Line >= '0' && *Line <= '9')
+      Line++;
+
+    if (*Line++ != '=')
+      return false;
+  } else if (*Line == '#') {
+    return false;
+  }
+
+  bool URL = SDL_strncasecmp(Line, "file://", 7) == 0;
+
+  if (URL) {
+    Line += 7;
+
+    if (SDL_strncasecmp(Line, "localhost/", 10) == 0)
+      Line += 9;
+
+    #ifdef WINDOWS
+    /* file:///C:/Music */
+    if (Line[0] == '/' && Line[1] != '\0' && Line[2] == ':')
+      Line++;
+    #endif
+  } else if (strstr(Line, "://")) {
+    return false;
+  }
+
+  if (*Line == '\0')
+    return false;
+
+  #ifndef WINDOWS
+  bool Absolute = Line[0] == '/' || Line[0] == '\\';
+  #else
+  bool Absolute = Line[0] == '\\' || Line[0] == '/' || (Line[0] != '\0' && Line[1] == ':');
+  #endif
+
+  size_t Used = 0;
+
+  if (!Absolute) {
+    memcpy(Out, Playlist, DirectoryLength);
+    Used = DirectoryLength;
+  }
+
+  for (; *Line; Line++) {
+    char Character = *Line;
+
+    if (URL && Character == '%' && HexDigit(Line[1]) != -1 && HexDigit(Line[2]) != -1) {
+      Character = HexDigit(Line[1]) << 4 | HexDigit(Line[2]);
+      Line += 2;
+    }
+
+    if (Used + 1 >= PLAYLIST_PATH_MAX)
+      return false;
+
+    Out[Used++] = Character == FOREIGN_SEPARATOR ? SEPARATOR : Character;
+  }
+
+  Out[Used] = '\0';
+  return true;
+}
+
+/*
+ * Calls Callback for up to Limit entries from byte *Offset on, and leaves *Offset at the line after
+ * the last one. Returns true if it stopped at Limit, so the rest is read by another call. Lines
+ * longer than the buffer can't be paths and are skipped.
+ */
+bool SA_PlaylistRead(const char *Path, uint64_t *Offset, uint32_t Limit, PlaylistEntry Callback, void *Data) {
+  SDL_IOStream *IO = SDL_IOFromFile(Path, "rb");
+  char *Buffer = malloc(PLAYLIST_BUFFER + 1);
+  char Entry[PLAYLIST_PATH_MAX];
+
+  if (!IO || !Buffer || SDL_SeekIO(IO, *Offset, SDL_IO_SEEK_SET) < 0) {
+    SDL_Log("Unable to read playlist \"%s\": %s", Path, SDL_GetError());
+
+    if (IO)
+      SDL_CloseIO(IO);
+
+    free(Buffer);
+    return false;
+  }
+
+  const char *Separator = strrchr(Path, '/'), *Backslash = strrchr(Path, '\\');
+
+  if (!Separator || (Backslash && Backslash > Separator))
+    Separator = Backslash;
+
+  size_t DirectoryLength = Separator ? (size_t)(Separator - Path) + 1 : 0;
+  bool PLS = IsPLS(Path), Skipping = false, More = false, End = false;
+  uint64_t Position = *Offset;
+  size_t Filled = 0;
+  uint32_t Count = 0;
+
+  while (!End && !More) {
+    size_t Read = SDL_ReadIO(IO, Buffer + Filled, PLAYLIST_BUFFER - Filled);
+    size_t Start = 0;
+
+    Filled += Read;
+    End = Read == 0;
+
+    while (Start < Filled) {
+      char *Newline = memchr(Buffer + Start, '\n', Filled - Start);
+
+      if (!Newline && !End)
+        break;
+
+      char *Line = Buffer + Start;
+      size_t Length = Newline ? (size_t)(Newline - Line) : Filled - Start;
+
+      Line[Length] = '\0';
+      Start += Length + (Newline ? 1 : 0);
+
+      if (Skipping) {
+        Skipping = false;
+        continue;
+      }
+
+      /* UTF-8 byte order mark */
+      if (Position + (uint64_t)(Line - Buffer) == 0 && Length >= 3 && memcmp(Line, "\xEF\xBB\xBF", 3) == 0)
+        Line += 3;
+
+      if (ParseLine(Line, PLS, Path, DirectoryLength, Entry)) {
+        Callback(Entry, Data);
+
+        if (++Count == Limit) {
+          More = true;
+          break;
+        }
+      }
+    }
+
+    if (Start == 0 && Filled == PLAYLIST_BUFFER) {
+      if (!Skipping)
+        SDL_Log("Skipping an overlong line in \"%s\".", Path);
+
+      Skipping = true;
+      Start = Filled;
+    }
+
+    memmove(Buffer, Buffer + Start, Filled - Start);
+    Position += Start;
+    Filled -= Start;
+  }
+
+  *Offset = Position;
+
+  SDL_CloseIO(IO);
+  free(Buffer);
+  return More;
+}
+
+static bool Live(const PlacedEntry *Entry) {
+  return Entry->Index < OrdinalCapacity && Ordinals[Entry->Index] == Entry->Ordinal;
+}
+
+/* Inserts Index at its ordinal. A full array drops its stale entries first, and grows only if that
+ * leaves it at least half full. Returns where the entry went. */
+static uint32_t Insert(uint32_t Index, uint64_t Ordinal) {
+  if (PlacedCount == PlacedCapacity) {
+    uint32_t Kept = 0;
+
+    for (uint32_t i = 0; i < PlacedCount; i++) {
+      if (Live(&Placed[i]))
+        Placed[Kept++] = Placed[i];
+    }
+
+    PlacedCount = Kept;
+
+    if (PlacedCount >= PlacedCapacity / 2) {
+      uint32_t Capacity = PlacedCapacity ? SA_GrowCapacity(PlacedCapacity) : 256;
+      PlacedEntry *l_Placed = realloc(Placed, sizeof(PlacedEntry) * Capacity);
+
+      if (!l_Placed) {
+        SDL_Log("[FATAL]: Unable to realloc placed playlist entries.\n");
+        exit(EXIT_FAILURE);
+      }
+
+      Placed = l_Placed;
+      PlacedCapacity = Capacity;
+    }
+  }
+
+  uint32_t Low = 0, High = PlacedCount;
+
+  while (Low < High) {
+    uint32_t Middle = Low + (High - Low) / 2;
+
+    if (Placed[Middle].Ordinal > Ordinal)
+      High = Middle;
+    else
+      Low = Middle + 1;
+  }
+
+  /* Entries arrive close to playlist order, so this rarely moves more than a few */
+  memmove(Placed + Low + 1, Placed + Low, sizeof(PlacedEntry) * (PlacedCount - Low));
+  Placed[Low] = (PlacedEntry){Ordinal, Index};
+  PlacedCount++;
+
+  return Low;
+}
+
+/* Whether Entry is another live track from the same playlist import as Index, still in its category. */
+static bool Neighbour(const PlacedEntry *Entry, uint32_t Index) {
+  return Entry->Index != Index && Entry->Ordinal >> 32 == Ordinals[Index] >> 32 && Live(Entry) &&
+         Audio[Entry->Index].Category == Audio[Index].Category;
+}
+
+/* Moves a track just added to the end of its category next to the entry before it in the same
+ * playlist, wherever that one is now, or in front of the entry after it. Tracks that were there
+ * before the playlist keep their place in front of it, and tracks dragged around since don't throw
+ * the placement off. */
+void SA_PlaylistPlace(uint32_t Index, uint64_t Ordinal) {
+  if (OrdinalCapacity < SA_TotalAudio) {
+    uint64_t *l_Ordinals = realloc(Ordinals, sizeof(uint64_t) * SA_TotalAudio);
+
+    if (!l_Ordinals) {
+      SDL_Log("[FATAL]: Unable to realloc playlist ordinals.\n");
+      exit(EXIT_FAILURE);
+    }
+
+    memset(&l_Ordinals[OrdinalCapacity], 0, sizeof(uint64_t) * (SA_TotalAudio - OrdinalCapacity));
+
+    Ordinals = l_Ordinals;
+    OrdinalCapacity = SA_TotalAudio;
+  }
+
+  uint8_t Category = Audio[Index].Category;
+  uint32_t Last = Categories[Category].Count - 1, Position = Last;
+
+  Ordinals[Index] = Ordinal;
+
+  uint32_t Slot = Insert(Index, Ordinal), Previous = Slot, Next = Slot + 1;
+
+  /* The nearest usable entries on either side, without leaving this import's range */
+  while (Previous > 0 && Placed[Previous - 1].Ordinal >> 32 == Ordinal >> 32 && !Neighbour(&Placed[Previous - 1], Index))
+    Previous--;
+
+  while (Next < PlacedCount && Placed[Next].Ordinal >> 32 == Ordinal >> 32 && !Neighbour(&Placed[Next], Index))
+    Next++;
+
+  if (Previous > 0 && Neighbour(&Placed[Previous - 1], Index))
+    Position = SA_CategoryPosition(Placed[Previous - 1].Index) + 1;
+  else if (Next < PlacedCount && Neighbour(&Placed[Next], Index))
+    Position = SA_CategoryPosition(Placed[Next].Index);
+
+  if (Position < Last) {
+    SA_CategoryMove(Category, Index, Position);
+    SA_QueueMove(Index);
+  }
+}
+
+void SA_PlaylistRemove(uint32_t Index) {
+  if (Index < OrdinalCapacity)
+    Ordinals[Index] = 0;
+}
+
+static void Flush(PlaylistWriter *Writer) {
+  if (Writer->Used && SDL_WriteIO(Writer->IO, Writer->Buffer, Writer->Used) != Writer->Used)
+    Writer->Failed = true;
+
+  Writer->Used = 0;
+}
+
+/* Formats into the buffer, flushing it first if the text doesn't fit. An entry is far smaller than
+ * the buffer, so a second try always fits. */
+static void Write(PlaylistWriter *Writer, const char *Format, ...) {
+  for (uint8_t Try = 0; Try < 2; Try++) {
+    va_list Arguments;
+
+    va_start(Arguments, Format);
+    int Length = vsnprintf(Writer->Buffer + Writer->Used, PLAYLIST_BUFFER - Writer->Used, Format, Arguments);
+    va_end(Arguments);
+
+    if (Length >= 0 && (size_t)Length < PLAYLIST_BUFFER - Writer->Used) {
+      Writer->Used += Length;
+      return;
+    }
+
+    Flush(Writer);
+  }
+
+  Writer->Failed = true;
+}
+
+/* Writes the category in layout order as extended M3U, or PLS if Path ends in .pls. Paths are
+ * written as stored, absolute. Unknown lengths are written as -1. */
+bool SA_PlaylistExport(uint8_t Category, const char *Path) {
+  PlaylistWriter Writer = {SDL_IOFromFile(Path, "wb"), malloc(PLAYLIST_BUFFER), 0, false};
+  bool PLS = IsPLS(Path);
+  uint32_t Count = 0;
+
+  if (!Writer.IO || !Writer.Buffer) {
+    SDL_Log("Unable to write playlist \"%s\": %s", Path, SDL_GetError());
+
+    if (Writer.IO)
+      SDL_CloseIO(Writer.IO);
+
+    free(Writer.Buffer);
+    return false;
+  }
+
+  Write(&Writer, PLS ? "[playlist]\n" : "#EXTM3U\n");
+
+  for (uint32_t Index = SA_OrderFirst(Categories[Category].Root); Index != ORDER_NIL; Index = SA_OrderNext(Index)) {
+    const char *Title = SA_String(Audio[Index].Title), *Artist = SA_String(Audio[Index].TagArtist);
+    int Seconds = Audio[Index].Duration > 0 ? (int)(Audio[Index].Duration + 0.5f) : -1;
+    bool HasArtist = strcmp(Artist, "N/A") != 0;
+
+    Count++;
+
+    if (PLS)
+      Write(&Writer, "File%u=%s\nTitle%u=%s\nLength%u=%d\n", Count, SA_String(Audio[Index].Path), Count, Title, Count, Seconds);
+    else
+      Write(&Writer, "#EXTINF:%d,%s%s%s\n%s\n", Seconds, HasArtist ? Artist : "", HasArtist ? " - " : "", Title, SA_String(Audio[Index].Path));
+  }
+
+  if (PLS)
+    Write(&Writer, "NumberOfEntries=%u\nVersion=2\n", Count);
+
+  Flush(&Writer);
+  Writer.Failed = !SDL_CloseIO(Writer.IO) || Writer.Failed;
+  free(Writer.Buffer);
+
+  if (Writer.Failed)
+    SDL_Log("Unable to write playlist \"%s\": %s", Path, SDL_GetError());
+  else
+    SDL_Log("Exported %u tracks to \"%s\".", Count, Path);
+
+  return !Writer.Failed;
+}
@@ -0,0 +1,27 @@
+#ifndef __SAPLAYLIST__
+#define __SAPLAYLIST__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * M3U, M3U8 and PLS playlists. Importing one fills the category named after the file: an import
+ * worker reads PLAYLIST_CHUNK entries at a time through a fixed buffer, and the next chunk is only
+ * queued once the main thread has handled the last one's entries, so a playlist of any length is
+ * read in constant memory. Entries
+ * already in the library are moved into the category, new ones go through the import workers, and
+ * both are put back in playlist order as they land. Exporting writes a category in one pass.
+ */
+#define PLAYLIST_CHUNK  512
+#define PLAYLIST_BUFFER (64 * 1024)
+
+typedef void (*PlaylistEntry)(const char *Path, void *Data);
+
+bool SA_IsPlaylist(const char *Path);
+void SA_PlaylistImport(const char *Path);
+bool SA_PlaylistRead(const char *Path, uint64_t *Offset, uint32_t Limit, PlaylistEntry Callback, void *Data);
+void SA_PlaylistPlace(uint32_t Index, uint64_t Ordinal);
+void SA_PlaylistRemove(uint32_t Index);
+bool SA_PlaylistExport(uint8_t Category, const char *Path);
+
+#endif
@@ -0,0 +1,186 @@
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio.h"
+#include "crossfade.h"
+#include "preload.h"
+
+#ifndef WINDOWS
+#define PRELOAD_PATH_MAX PATH_MAX
+#else
+#define PRELOAD_PATH_MAX MAX_PATH
+#endif
+
+enum PreloadState {
+  PRELOAD_IDLE,
+  PRELOAD_REQUESTED,
+  PRELOAD_LOADING,
+  PRELOAD_READY
+};
+
+static SDL_Thread *Loader;
+static SDL_Mutex *Lock;
+static SDL_Condition *Requested;
+static bool Quit;
+
+/* The slot the loader fills, guarded by Lock. A handle loaded for a request that was replaced
+ * while it was opening is handed back through Stale and freed by the main thread. */
+static uint8_t State, SlotParts;
+static uint32_t SlotIndex;
+static char SlotPath[PRELOAD_PATH_MAX];
+static Mix_Music *SlotMusic, *Stale;
+
+static int PreloadThread(void *Data) {
+  (void)Data;
+  char Path[PRELOAD_PATH_MAX];
+
+  SDL_LockMutex(Lock);
+
+  for (;;) {
+    while (State != PRELOAD_REQUESTED && !Quit)
+      SDL_WaitCondition(Requested, Lock);
+
+    if (Quit)
+      break;
+
+    uint32_t Index = SlotIndex;
+    uint8_t Parts = SlotParts;
+    Mix_Music *Music = NULL;
+
+    memcpy(Path, SlotPath, sizeof(Path));
+    State = PRELOAD_LOADING;
+    SDL_UnlockMutex(Lock);
+
+    if (Parts & PRELOAD_OPEN) {
+      Music = Mix_LoadMUS(Path);
+
+      if (!Music)
+        SDL_Log("Unable to preload \"%s\": %s", Path, SDL_GetError());
+    }
+
+    SDL_LockMutex(Lock);
+
+    /* Replaced while it was opening, the newer request is picked up on the next pass */
+    bool Current = State == PRELOAD_LOADING && SlotIndex == Index;
+
+    if (Current) {
+      SlotMusic = Music;
+      State = Music ? PRELOAD_READY : PRELOAD_IDLE;
+    } else if (Music) {
+      if (Stale)
+        Mix_FreeMusic(Stale);
+
+      Stale = Music;
+    }
+
+    /* The handle can be taken while the start is decoded for a crossfade */
+    if (Current && (Parts & PRELOAD_HEAD)) {
+      SDL_UnlockMutex(Lock);
+      SA_CrossfadeDecode(Index, Path);
+      SDL_LockMutex(Lock);
+    }
+  }
+
+  SDL_UnlockMutex(Lock);
+  return 0;
+}
+
+void InitializePreload() {
+  Lock = SDL_CreateMutex();
+  Requested = SDL_CreateCondition();
+  Loader = Lock && Requested ? SDL_CreateThread(PreloadThread, "SA_Preload", NULL) : NULL;
+
+  if (!Loader) {
+    SDL_Log("[FATAL]: Unable to create the preload thread: %s\n", SDL_GetError());
+    exit(EXIT_FAILURE);
+  }
+}
+
+void ShutdownPreload() {
+  SDL_LockMutex(Lock);
+  Quit = true;
+  SDL_SignalCondition(Requested);
+  SDL_UnlockMutex(Lock);
+
+  SDL_WaitThread(Loader, NULL);
+
+  if (SlotMusic)
+    Mix_FreeMusic(SlotMusic);
+
+  if (Stale)
+    Mix_FreeMusic(Stale);
+
+  SDL_DestroyCondition(Requested);
+  SDL_DestroyMutex(Lock);
+}
+
+/* Asks for the Parts of Index to be prepared. Work already done or underway for Index is kept if it
+ * covers them. */
+void SA_PreloadRequest(uint32_t Index, const char *Path, uint8_t Parts) {
+  Mix_Music *Dropped = NULL, *l_Stale;
+
+  if (strlen(Path) >= PRELOAD_PATH_MAX)
+    return;
+
+  SDL_LockMutex(Lock);
+
+  l_Stale = Stale;
+  Stale = NULL;
+
+  if (State == PRELOAD_IDLE || SlotIndex != Index || (SlotParts & Parts) != Parts) {
+    if (State == PRELOAD_READY)
+      Dropped = SlotMusic;
+
+    SlotMusic = NULL;
+    SlotIndex = Index;
+    SlotParts = Parts;
+    strcpy(SlotPath, Path);
+    State = PRELOAD_REQUESTED;
+    SDL_SignalCondition(Requested);
+  }
+
+  SDL_UnlockMutex(Lock);
+
+  if (Dropped)
+    Mix_FreeMusic(Dropped);
+
+  if (l_Stale)
+    Mix_FreeMusic(l_Stale);
+}
+
+/* The opened handle for Index, now owned by the caller, or NULL if it isn't ready. The path is
+ * checked as well, the slot may have been given to another track since the request. */
+Mix_Music *SA_PreloadTake(uint32_t Index, const char *Path) {
+  Mix_Music *Music = NULL;
+
+  SDL_LockMutex(Lock);
+
+  if (State == PRELOAD_READY && SlotIndex == Index && strcmp(SlotPath, Path) == 0) {
+    Music = SlotMusic;
+    SlotMusic = NULL;
+    State = PRELOAD_IDLE;
+  }
+
+  SDL_UnlockMutex(Lock);
+  return Music;
+}
+
+/* Drops whatever was opened for a track that changed or left the library. A load still underway
+ * is left to finish and handed back as stale. */
+void SA_PreloadForget(uint32_t Index) {
+  Mix_Music *Dropped = NULL;
+
+  SDL_LockMutex(Lock);
+
+  if (State != PRELOAD_IDLE && SlotIndex == Index) {
+    Dropped = SlotMusic;
+    SlotMusic = NULL;
+    State = PRELOAD_IDLE;
+  }
+
+  SDL_UnlockMutex(Lock);
+
+  if (Dropped)
+    Mix_FreeMusic(Dropped);
+}
@@ -0,0 +1,26 @@
+#ifndef __SAPRELOAD__
+#define __SAPRELOAD__
+
+#include <stdint.h>
+
+#ifndef WINDOWS
+#include <SDL3_mixer/SDL_mixer.h>
+#else
+#include <SDL3/SDL_mixer.h>
+#endif
+
+/*
+ * Opens the track that plays next on a thread of its own while the current one plays, so a track
+ * change doesn't wait on the disk or on setting up a decoder. One track is kept ready at a time;
+ * asking for another one drops it. Only the main thread calls these.
+ */
+#define PRELOAD_OPEN 1 /* Open a decoder for it */
+#define PRELOAD_HEAD 2 /* Decode its start for a crossfade, see crossfade.h */
+
+void InitializePreload();
+void ShutdownPreload();
+void SA_PreloadRequest(uint32_t Index, const char *Path, uint8_t Parts);
+Mix_Music *SA_PreloadTake(uint32_t Index, const char *Path);
+void SA_PreloadForget(uint32_t Index);
+
+#endif
@@ -0,0 +1,242 @@
+#include <SDL3/SDL.h>
+#include <stdlib.h>
+
+#include "audio.h"
+#include "category.h"
+#include "order.h"
+#include "queue.h"
+
+#define QUEUE_NIL UINT32_MAX
+
+typedef struct {
+  uint32_t Next, Prev;
+} QueueLink;
+
+bool QueueShuffle = false;
+
+static QueueLink *Links;
+static uint32_t LinkCapacity;
+
+static uint32_t Head = QUEUE_NIL;
+static uint8_t QueueCategory;
+
+/* The track the next shuffled cycle starts with. Drawn the first time the end of a cycle is peeked
+ * at, so the track opened ahead of time is the one that plays once the cycle really wraps. */
+static uint32_t CycleStart = QUEUE_NIL;
+
+void SA_QueueResize(uint32_t Capacity) {
+  if (Capacity <= LinkCapacity)
+    return;
+
+  QueueLink *l_Links = realloc(Links, sizeof(QueueLink) * Capacity);
+
+  if (!l_Links) {
+    SDL_Log("[FATAL]: Unable to realloc queue links.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (uint32_t i = LinkCapacity; i < Capacity; i++)
+    l_Links[i] = (QueueLink){QUEUE_NIL, QUEUE_NIL};
+
+  Links = l_Links;
+  LinkCapacity = Capacity;
+}
+
+bool SA_QueueContains(uint32_t Index) {
+  return Index < LinkCapacity && Links[Index].Next != QUEUE_NIL;
+}
+
+static void LinkAfter(uint32_t Index, uint32_t After) {
+  if (After == QUEUE_NIL) {
+    Links[Index] = (QueueLink){Index, Index};
+    Head = Index;
+    return;
+  }
+
+  uint32_t Next = Links[After].Next;
+
+  Links[Index] = (QueueLink){Next, After};
+  Links[After].Next = Index;
+  Links[Next].Prev = Index;
+}
+
+static void Unlink(uint32_t Index) {
+  QueueLink Link = Links[Index];
+
+  if (Link.Next == Index) {
+    Head = QUEUE_NIL;
+  } else {
+    Links[Link.Prev].Next = Link.Next;
+    Links[Link.Next].Prev = Link.Prev;
+
+    if (Head == Index)
+      Head = Link.Next;
+  }
+
+  Links[Index] = (QueueLink){QUEUE_NIL, QUEUE_NIL};
+}
+
+static void Clear() {
+  while (Head != QUEUE_NIL)
+    Unlink(Head);
+}
+
+/* Links the category in a fresh Fisher-Yates order, with Start (if any) moved to the front. */
+static void BuildShuffled(int32_t Start) {
+  uint32_t Count = Categories[QueueCategory].Count;
+  uint32_t *Order = malloc(sizeof(uint32_t) * Count);
+
+  if (!Order) {
+    SDL_Log("[FATAL]: Unable to allocate the shuffle order.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  uint32_t n = 0;
+
+  for (uint32_t i = SA_OrderFirst(Categories[QueueCategory].Root); i != ORDER_NIL; i = SA_OrderNext(i))
+    Order[n++] = i;
+
+  for (uint32_t i = Count; i > 1; i--) {
+    uint32_t j = SDL_rand(i);
+    uint32_t Swap = Order[i - 1];
+    Order[i - 1] = Order[j];
+    Order[j] = Swap;
+  }
+
+  if (Start != -1) {
+    LinkAfter(Start, QUEUE_NIL);
+  }
+
+  for (uint32_t i = 0; i < Count; i++) {
+    if ((int32_t)Order[i] != Start)
+      LinkAfter(Order[i], Head == QUEUE_NIL ? QUEUE_NIL : Links[Head].Prev);
+  }
+
+  free(Order);
+}
+
+void SA_QueueBuild(uint8_t Category, uint32_t Start) {
+  Clear();
+  CycleStart = QUEUE_NIL;
+  SA_QueueResize(SA_TotalAudio);
+  QueueCategory = Category;
+
+  if (QueueShuffle) {
+    BuildShuffled(Start);
+    return;
+  }
+
+  for (uint32_t i = SA_OrderFirst(Categories[Category].Root); i != ORDER_NIL; i = SA_OrderNext(i))
+    LinkAfter(i, Head == QUEUE_NIL ? QUEUE_NIL : Links[Head].Prev);
+}
+
+static bool CycleEnds(uint32_t Index) {
+  return QueueShuffle && Links[Index].Next == Head && Categories[QueueCategory].Count > 1;
+}
+
+/* Draws the start of the next shuffled cycle if it isn't drawn yet, anything but the track just played. */
+static uint32_t NextCycleStart(uint32_t Index) {
+  if (CycleStart != QUEUE_NIL && CycleStart != Index && SA_QueueContains(CycleStart))
+    return CycleStart;
+
+  uint32_t Root = Categories[QueueCategory].Root;
+  uint32_t Start = SA_OrderAt(Root, SDL_rand(Categories[QueueCategory].Count));
+
+  if (Start == Index)
+    Start = SA_OrderNext(Start) != ORDER_NIL ? SA_OrderNext(Start) : SA_OrderFirst(Root);
+
+  CycleStart = Start;
+  return Start;
+}
+
+/* The track after Index, without drawing a new permutation at the end of a shuffled cycle. */
+int32_t SA_QueuePeek(uint32_t Index) {
+  if (!SA_QueueContains(Index))
+    return -1;
+
+  return CycleEnds(Index) ? (int32_t)NextCycleStart(Index) : (int32_t)Links[Index].Next;
+}
+
+/* Advances past Index. A shuffled cycle that is over is replaced by a new permutation. */
+int32_t SA_QueueNext(uint32_t Index) {
+  if (!SA_QueueContains(Index))
+    return -1;
+
+  if (CycleEnds(Index)) {
+    uint32_t Start = NextCycleStart(Index);
+
+    Clear();
+    BuildShuffled(Start);
+    CycleStart = QUEUE_NIL;
+
+    return Head;
+  }
+
+  return Links[Index].Next;
+}
+
+int32_t SA_QueuePrevious(uint32_t Index) {
+  if (!SA_QueueContains(Index))
+    return -1;
+
+  return Links[Index].Prev;
+}
+
+/* Links a track added to the library after the queue was built. */
+void SA_QueueInsert(uint32_t Index) {
+  if (Head == QUEUE_NIL || Audio[Index].Category != QueueCategory)
+    return;
+
+  SA_QueueResize(SA_TotalAudio);
+
+  if (QueueShuffle) {
+    /* After a random earlier member; the new track itself is the last one in the category */
+    uint32_t After = SA_OrderAt(Categories[QueueCategory].Root, SDL_rand(Categories[QueueCategory].Count - 1));
+
+    if (!SA_QueueContains(After))
+      After = Links[Head].Prev;
+
+    LinkAfter(Index, After);
+    return;
+  }
+
+  SA_QueueMove(Index);
+}
+
+void SA_QueueRemove(uint32_t Index) {
+  if (CycleStart == Index)
+    CycleStart = QUEUE_NIL;
+
+  if (SA_QueueContains(Index))
+    Unlink(Index);
+}
+
+/* Puts a track back in its category position after a reorder. Shuffled queues are unaffected. */
+void SA_QueueMove(uint32_t Index) {
+  if (QueueShuffle || Head == QUEUE_NIL || Audio[Index].Category != QueueCategory)
+    return;
+
+  if (SA_QueueContains(Index))
+    Unlink(Index);
+
+  uint32_t Position = SA_OrderPosition(Index);
+
+  if (Head == QUEUE_NIL) {
+    LinkAfter(Index, QUEUE_NIL);
+  } else if (Position == 0) {
+    LinkAfter(Index, Links[Head].Prev);
+    Head = Index;
+  } else {
+    LinkAfter(Index, SA_OrderAt(Categories[QueueCategory].Root, Position - 1));
+  }
+}
+
+void SA_QueueSetShuffle(bool Shuffle, int32_t Current) {
+  QueueShuffle = Shuffle;
+  CycleStart = QUEUE_NIL;
+
+  if (Current != -1)
+    SA_QueueBuild(Audio[Current].Category, Current);
+  else
+    Clear();
+}
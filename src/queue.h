@@ -0,0 +1,26 @@
+#ifndef __SAQUEUE__
+#define __SAQUEUE__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Playback queue built from one category. It is a circular doubly linked list over library
+ * indices, so next/previous are O(1). In shuffle mode the list follows a Fisher-Yates permutation:
+ * every track plays once per cycle, and a new permutation is drawn when the cycle wraps. Peek only
+ * looks ahead; Next is for actually moving on, as it may draw that permutation.
+ */
+extern bool QueueShuffle;
+
+void SA_QueueResize(uint32_t Capacity);
+void SA_QueueBuild(uint8_t Category, uint32_t Start);
+bool SA_QueueContains(uint32_t Index);
+int32_t SA_QueuePeek(uint32_t Index);
+int32_t SA_QueueNext(uint32_t Index);
+int32_t SA_QueuePrevious(uint32_t Index);
+void SA_QueueInsert(uint32_t Index);
+void SA_QueueRemove(uint32_t Index);
+void SA_QueueMove(uint32_t Index);
+void SA_QueueSetShuffle(bool Shuffle, int32_t Current);
+
+#endif
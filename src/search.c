@@ -0,0 +1,276 @@
+#include <SDL3/SDL.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "audio.h"
+#include "category.h"
+#include "order.h"
+#include "search.h"
+
+typedef struct {
+  uint32_t *Indices;
+  uint32_t Count, Capacity;
+} PostingList;
+
+static PostingList *Buckets;
+
+/* Removal only counts the entries it leaves behind, so it never scans a posting list. A stale entry
+ * points at a freed slot or at a track whose text changed; queries verify every candidate against
+ * the current text anyway, and skip an index seen twice. Once stale entries outnumber live ones the
+ * index is rebuilt, see SA_SearchCompact(). */
+static uint64_t Entries, Stale;
+
+/* Per-index stamp of the last query that returned it, so one listed twice is returned once */
+static uint32_t *Seen;
+static uint32_t SeenCapacity, QueryStamp;
+
+/* Results are sorted as (layout position << 32 | index) keys, so every position is looked up once.
+ * Sized like Seen. */
+static uint64_t *SortKeys;
+
+/* Scratch space for the trigram keys of a single track, only touched on insert/remove. */
+static uint16_t *TrackKeys;
+static uint32_t TrackKeysCapacity;
+
+static inline uint16_t TrigramKey(const char *Text) {
+  uint32_t Trigram = (uint32_t)tolower((unsigned char)Text[0]) << 16 |
+                     (uint32_t)tolower((unsigned char)Text[1]) << 8 |
+                     (uint32_t)tolower((unsigned char)Text[2]);
+
+  return (Trigram * 2654435761u) >> 16;
+}
+
+static int CompareKeys(const void *A, const void *B) {
+  return (int)*(const uint16_t *)A - (int)*(const uint16_t *)B;
+}
+
+/* Collects the distinct trigram keys of a track into TrackKeys and returns how many there are. */
+static uint32_t CollectKeys(uint32_t Index) {
+  const char *Fields[] = {SA_String(Audio[Index].Title), SA_String(Audio[Index].TagArtist), SA_String(Audio[Index].TagAlbum)};
+  uint32_t Count = 0, Needed = 0;
+
+  for (uint8_t i = 0; i < 3; i++)
+    Needed += strlen(Fields[i]);
+
+  if (Needed > TrackKeysCapacity) {
+    uint16_t *l_Keys = realloc(TrackKeys, sizeof(uint16_t) * Needed);
+
+    if (!l_Keys) {
+      SDL_Log("[FATAL]: Unable to realloc the search key buffer.\n");
+      exit(EXIT_FAILURE);
+    }
+
+    TrackKeys = l_Keys;
+    TrackKeysCapacity = Needed;
+  }
+
+  for (uint8_t i = 0; i < 3; i++) {
+    const char *Text = Fields[i];
+
+    for (size_t j = 0; Text[j] && Text[j + 1] && Text[j + 2]; j++)
+      TrackKeys[Count++] = TrigramKey(Text + j);
+  }
+
+  if (Count == 0)
+    return 0;
+
+  /* A track has a few dozen keys, insertion sort beats qsort's callbacks there */
+  if (Count > 64) {
+    qsort(TrackKeys, Count, sizeof(uint16_t), CompareKeys);
+  } else {
+    for (uint32_t i = 1; i < Count; i++) {
+      uint16_t Key = TrackKeys[i];
+      uint32_t j = i;
+
+      for (; j > 0 && TrackKeys[j - 1] > Key; j--)
+        TrackKeys[j] = TrackKeys[j - 1];
+
+      TrackKeys[j] = Key;
+    }
+  }
+
+  uint32_t Unique = 1;
+
+  for (uint32_t i = 1; i < Count; i++)
+    if (TrackKeys[i] != TrackKeys[Unique - 1])
+      TrackKeys[Unique++] = TrackKeys[i];
+
+  return Unique;
+}
+
+void InitializeSearch() {
+  Buckets = calloc(SEARCH_BUCKETS, sizeof(PostingList));
+
+  if (!Buckets) {
+    SDL_Log("[FATAL]: Unable to allocate the search index.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+/* Grown with the library, so queries never allocate. */
+void SA_SearchResize(uint32_t Capacity) {
+  if (Capacity <= SeenCapacity)
+    return;
+
+  uint32_t *l_Seen = realloc(Seen, sizeof(uint32_t) * Capacity);
+  uint64_t *l_Keys = realloc(SortKeys, sizeof(uint64_t) * Capacity);
+
+  if (!l_Seen || !l_Keys) {
+    SDL_Log("[FATAL]: Unable to realloc the search buffers.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  memset(l_Seen + SeenCapacity, 0, sizeof(uint32_t) * (Capacity - SeenCapacity));
+  Seen = l_Seen;
+  SortKeys = l_Keys;
+  SeenCapacity = Capacity;
+}
+
+void SA_SearchInsert(uint32_t Index) {
+  uint32_t Count = CollectKeys(Index);
+
+  for (uint32_t i = 0; i < Count; i++) {
+    PostingList *List = &Buckets[TrackKeys[i]];
+
+    if (List->Count == List->Capacity) {
+      uint32_t Capacity = List->Capacity ? SA_GrowCapacity(List->Capacity) : 4;
+      uint32_t *l_Indices = realloc(List->Indices, sizeof(uint32_t) * Capacity);
+
+      if (!l_Indices) {
+        SDL_Log("[FATAL]: Unable to realloc a search posting list.\n");
+        exit(EXIT_FAILURE);
+      }
+
+      List->Indices = l_Indices;
+      List->Capacity = Capacity;
+    }
+
+    List->Indices[List->Count++] = Index;
+  }
+
+  Entries += Count;
+}
+
+/* O(keys of the track), the entries themselves stay until the next compaction. */
+void SA_SearchRemove(uint32_t Index) {
+  Stale += CollectKeys(Index);
+}
+
+/* Rebuilds the index from the library once most of it is stale. Amortised over the removals that
+ * made it so, that stays O(1) per removal. Only call with the library consistent (no track half
+ * removed), the callers do it when a batch is committed. */
+void SA_SearchCompact() {
+  if (Stale < SEARCH_COMPACT_MIN || Stale * 2 < Entries)
+    return;
+
+  for (uint32_t i = 0; i < SEARCH_BUCKETS; i++)
+    Buckets[i].Count = 0;
+
+  Entries = Stale = 0;
+
+  for (uint32_t i = 0; i < SA_TotalAudio; i++) {
+    if (Audio[i].Path != 0)
+      SA_SearchInsert(i);
+  }
+}
+
+/* Case-insensitive strstr against an already lowered Needle, without copying Haystack. */
+static bool ContainsLowered(const char *Haystack, const char *Needle) {
+  for (; *Haystack; Haystack++) {
+    uint32_t i = 0;
+
+    while (Needle[i] && tolower((unsigned char)Haystack[i]) == Needle[i])
+      i++;
+
+    if (Needle[i] == 0)
+      return true;
+  }
+
+  return Needle[0] == 0;
+}
+
+bool SA_SearchMatches(uint32_t Index, const char *Query) {
+  return ContainsLowered(SA_String(Audio[Index].Title), Query) ||
+         ContainsLowered(SA_String(Audio[Index].TagArtist), Query) ||
+         ContainsLowered(SA_String(Audio[Index].TagAlbum), Query);
+}
+
+
+static void SiftDown(uint64_t *Keys, uint32_t Root, uint32_t Count) {
+  for (uint32_t Child; (Child = Root * 2 + 1) < Count; Root = Child) {
+    if (Child + 1 < Count && Keys[Child + 1] > Keys[Child])
+      Child += 1;
+
+    if (Keys[Root] >= Keys[Child])
+      return;
+
+    uint64_t Swap = Keys[Root];
+    Keys[Root] = Keys[Child];
+    Keys[Child] = Swap;
+  }
+}
+
+/* In-place heapsort into layout order. The key buffer grows with the library, see SA_SearchResize(). */
+static void SortByOrder(uint32_t *Results, uint32_t Count) {
+  for (uint32_t i = 0; i < Count; i++)
+    SortKeys[i] = (uint64_t)SA_OrderPosition(Results[i]) << 32 | Results[i];
+
+  for (uint32_t i = Count / 2; i > 0; i--)
+    SiftDown(SortKeys, i - 1, Count);
+
+  for (uint32_t i = Count; i > 1; i--) {
+    uint64_t Swap = SortKeys[0];
+    SortKeys[0] = SortKeys[i - 1];
+    SortKeys[i - 1] = Swap;
+
+    SiftDown(SortKeys, 0, i - 1);
+  }
+
+  for (uint32_t i = 0; i < Count; i++)
+    Results[i] = (uint32_t)SortKeys[i];
+}
+
+/*
+ * Writes the members of Category matching the lowered Query into Results, in layout order.
+ * Returns -1 when the query is shorter than a trigram and the caller has to scan instead.
+ */
+int32_t SA_SearchQuery(const char *Query, uint8_t Category, uint32_t *Results) {
+  size_t Length = strlen(Query);
+
+  if (Length < SEARCH_MIN_QUERY)
+    return -1;
+
+  PostingList *Shortest = &Buckets[TrigramKey(Query)];
+
+  for (size_t i = 1; i + 2 < Length; i++) {
+    PostingList *List = &Buckets[TrigramKey(Query + i)];
+
+    if (List->Count < Shortest->Count)
+      Shortest = List;
+  }
+
+  /* Stamps start over when the counter wraps, rather than match a query four billion ago */
+  if (++QueryStamp == 0) {
+    memset(Seen, 0, sizeof(uint32_t) * SeenCapacity);
+    QueryStamp = 1;
+  }
+
+  uint32_t Count = 0;
+
+  for (uint32_t i = 0; i < Shortest->Count; i++) {
+    uint32_t Index = Shortest->Indices[i];
+
+    if (Index >= SA_TotalAudio || Seen[Index] == QueryStamp || Audio[Index].Path == 0)
+      continue;
+
+    Seen[Index] = QueryStamp;
+
+    if (Audio[Index].Category == Category && SA_SearchMatches(Index, Query))
+      Results[Count++] = Index;
+  }
+
+  SortByOrder(Results, Count);
+  return Count;
+}
@@ -0,0 +1,24 @@
+#ifndef __SASEARCH__
+#define __SASEARCH__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Trigram index over the case-folded title, artist and album of every track. Each trigram hashes
+ * into one of SEARCH_BUCKETS posting lists of library indices. A query probes the shortest list
+ * among its trigrams and verifies those candidates only. Queries never allocate.
+ */
+#define SEARCH_BUCKETS (1 << 16)
+#define SEARCH_MIN_QUERY 3
+#define SEARCH_COMPACT_MIN 4096 /* Stale entries tolerated before a rebuild is considered */
+
+void InitializeSearch();
+void SA_SearchResize(uint32_t Capacity);
+void SA_SearchInsert(uint32_t Index);
+void SA_SearchRemove(uint32_t Index);
+void SA_SearchCompact();
+bool SA_SearchMatches(uint32_t Index, const char *Query);
+int32_t SA_SearchQuery(const char *Query, uint8_t Category, uint32_t *Results);
+
+#endif
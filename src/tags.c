@@ -0,0 +1,731 @@
+#include <SDL3/SDL.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef WINDOWS
+#include <SDL3_mixer/SDL_mixer.h>
+#else
+#include <SDL3/SDL_mixer.h>
+#endif
+
+#include "tags.h"
+
+/* Upper bounds on what is read for a single frame, comment packet or INFO list. Cover art and
+ * other large blobs past these limits are never loaded. */
+#define TAG_FRAME_MAX   2048
+#define TAG_BLOCK_MAX   (256 * 1024)
+#define TAG_OGG_PAGES   16
+
+/* How much of the end of an Ogg file is searched for its last page, and how far past an ID3v2 tag
+ * the first MPEG frame is looked for. */
+#define TAG_OGG_TAIL    (64 * 1024)
+#define TAG_MPEG_SCAN   4096
+
+enum TagFormat {
+  FORMAT_UNKNOWN,
+  FORMAT_MPEG,
+  FORMAT_FLAC
+};
+
+static inline uint32_t ReadBE32(const uint8_t *Data) {
+  return (uint32_t)Data[0] << 24 | (uint32_t)Data[1] << 16 | (uint32_t)Data[2] << 8 | Data[3];
+}
+
+static inline uint32_t ReadLE32(const uint8_t *Data) {
+  return (uint32_t)Data[3] << 24 | (uint32_t)Data[2] << 16 | (uint32_t)Data[1] << 8 | Data[0];
+}
+
+static inline uint64_t ReadLE64(const uint8_t *Data) {
+  return (uint64_t)ReadLE32(Data + 4) << 32 | ReadLE32(Data);
+}
+
+static inline uint32_t ReadSynchsafe(const uint8_t *Data) {
+  return (uint32_t)(Data[0] & 0x7F) << 21 | (uint32_t)(Data[1] & 0x7F) << 14 | (uint32_t)(Data[2] & 0x7F) << 7 | (Data[3] & 0x7F);
+}
+
+static bool ReadExact(SDL_IOStream *IO, void *Data, size_t Length) {
+  return SDL_ReadIO(IO, Data, Length) == Length;
+}
+
+/* Appends a code point as UTF-8 if it fits, keeping room for the terminator. */
+static size_t PutUTF8(char *Dest, size_t Length, uint32_t Code) {
+  uint8_t Bytes = Code < 0x80 ? 1 : Code < 0x800 ? 2 : Code < 0x10000 ? 3 : 4;
+
+  if (Length + Bytes >= TAG_LENGTH)
+    return Length;
+
+  if (Bytes == 1) {
+    Dest[Length] = Code;
+  } else if (Bytes == 2) {
+    Dest[Length] = 0xC0 | Code >> 6;
+    Dest[Length + 1] = 0x80 | (Code & 0x3F);
+  } else if (Bytes == 3) {
+    Dest[Length] = 0xE0 | Code >> 12;
+    Dest[Length + 1] = 0x80 | (Code >> 6 & 0x3F);
+    Dest[Length + 2] = 0x80 | (Code & 0x3F);
+  } else {
+    Dest[Length] = 0xF0 | Code >> 18;
+    Dest[Length + 1] = 0x80 | (Code >> 12 & 0x3F);
+    Dest[Length + 2] = 0x80 | (Code >> 6 & 0x3F);
+    Dest[Length + 3] = 0x80 | (Code & 0x3F);
+  }
+
+  return Length + Bytes;
+}
+
+/* Copies UTF-8 text, stopping at a NUL or before a sequence that wouldn't fit. */
+static void SetUTF8(char *Dest, const uint8_t *Source, size_t Length) {
+  size_t Out = 0;
+
+  for (size_t i = 0; i < Length && Source[i] != 0; i++) {
+    if (Out + 1 >= TAG_LENGTH)
+      break;
+
+    Dest[Out++] = Source[i];
+  }
+
+  /* Don't leave half a code point behind */
+  if (Out + 1 >= TAG_LENGTH) {
+    while (Out > 0 && ((uint8_t)Dest[Out - 1] & 0xC0) == 0x80)
+      Out--;
+
+    if (Out > 0 && (uint8_t)Dest[Out - 1] >= 0xC0)
+      Out--;
+  }
+
+  while (Out > 0 && Dest[Out - 1] == ' ')
+    Out--;
+
+  Dest[Out] = '\0';
+}
+
+static void SetLatin1(char *Dest, const uint8_t *Source, size_t Length) {
+  size_t Out = 0;
+
+  for (size_t i = 0; i < Length && Source[i] != 0; i++)
+    Out = PutUTF8(Dest, Out, Source[i]);
+
+  while (Out > 0 && Dest[Out - 1] == ' ')
+    Out--;
+
+  Dest[Out] = '\0';
+}
+
+static void SetUTF16(char *Dest, const uint8_t *Source, size_t Length, bool BigEndian) {
+  size_t Out = 0;
+
+  for (size_t i = 0; i + 1 < Length; i += 2) {
+    uint32_t Code = BigEndian ? (Source[i] << 8 | Source[i + 1]) : (Source[i + 1] << 8 | Source[i]);
+
+    if (Code == 0)
+      break;
+
+    if (Code >= 0xD800 && Code < 0xDC00 && i + 3 < Length) {
+      uint32_t Low = BigEndian ? (Source[i + 2] << 8 | Source[i + 3]) : (Source[i + 3] << 8 | Source[i + 2]);
+
+      if (Low >= 0xDC00 && Low < 0xE000) {
+        Code = 0x10000 + ((Code - 0xD800) << 10) + (Low - 0xDC00);
+        i += 2;
+      }
+    }
+
+    Out = PutUTF8(Dest, Out, Code);
+  }
+
+  Dest[Out] = '\0';
+}
+
+/* Maps a tag key onto one of the fields, NULL when the key isn't one we keep. */
+static char *TagField(AudioTags *Tags, const char *Key, size_t Length) {
+  static const struct {
+    const char *Key;
+    size_t Field;
+  } Keys[] = {
+    {"TITLE", offsetof(AudioTags, Title)}, {"ARTIST", offsetof(AudioTags, Artist)},
+    {"ALBUM", offsetof(AudioTags, Album)}, {"COPYRIGHT", offsetof(AudioTags, Copyright)},
+    {"TIT2", offsetof(AudioTags, Title)}, {"TPE1", offsetof(AudioTags, Artist)},
+    {"TALB", offsetof(AudioTags, Album)}, {"TCOP", offsetof(AudioTags, Copyright)},
+    {"TT2", offsetof(AudioTags, Title)}, {"TP1", offsetof(AudioTags, Artist)},
+    {"TAL", offsetof(AudioTags, Album)}, {"TCR", offsetof(AudioTags, Copyright)},
+    {"INAM", offsetof(AudioTags, Title)}, {"IART", offsetof(AudioTags, Artist)},
+    {"IPRD", offsetof(AudioTags, Album)}, {"ICOP", offsetof(AudioTags, Copyright)}
+  };
+
+  for (uint8_t i = 0; i < SDL_arraysize(Keys); i++) {
+    if (strlen(Keys[i].Key) == Length && SDL_strncasecmp(Keys[i].Key, Key, Length) == 0)
+      return (char *)Tags + Keys[i].Field;
+  }
+
+  return NULL;
+}
+
+/* ID3v2 text frame: an encoding byte, then the text. Only the first of several values is kept. */
+static void SetID3Text(char *Dest, const uint8_t *Data, size_t Length) {
+  if (Length < 1)
+    return;
+
+  switch (Data[0]) {
+    case 0: SetLatin1(Dest, Data + 1, Length - 1); break;
+    case 3: SetUTF8(Dest, Data + 1, Length - 1); break;
+    case 2: SetUTF16(Dest, Data + 1, Length - 1, true); break;
+    case 1: {
+      bool BigEndian = Length >= 3 && Data[1] == 0xFE && Data[2] == 0xFF;
+      bool BOM = Length >= 3 && ((Data[1] == 0xFF && Data[2] == 0xFE) || BigEndian);
+
+      SetUTF16(Dest, Data + 1 + (BOM ? 2 : 0), Length - 1 - (BOM ? 2 : 0), BigEndian);
+      break;
+    }
+  }
+}
+
+/* Undoes ID3 unsynchronisation (0xFF 0x00 -> 0xFF) in place, returns the new length. */
+static size_t Resync(uint8_t *Data, size_t Length) {
+  size_t Out = 0;
+
+  for (size_t i = 0; i < Length; i++) {
+    Data[Out++] = Data[i];
+
+    if (Data[i] == 0xFF && i + 1 < Length && Data[i + 1] == 0x00)
+      i++;
+  }
+
+  return Out;
+}
+
+/* Parses an ID3v2 tag at the start of the stream. Returns the offset right after it, 0 if none. */
+static uint32_t ReadID3v2(SDL_IOStream *IO, AudioTags *Tags) {
+  uint8_t Header[10];
+
+  if (!ReadExact(IO, Header, 10) || memcmp(Header, "ID3", 3) != 0 || Header[3] < 2 || Header[3] > 4)
+    return 0;
+
+  uint8_t Version = Header[3], Flags = Header[5];
+  uint32_t End = 10 + ReadSynchsafe(Header + 6) + (Flags & 0x10 ? 10 : 0);
+  uint64_t Position = 10;
+  uint8_t FrameHeader = Version == 2 ? 6 : 10;
+  uint8_t Frame[TAG_FRAME_MAX];
+
+  /* Extended header, v2.3 stores its size without itself */
+  if (Version > 2 && (Flags & 0x40)) {
+    uint8_t Size[4];
+
+    if (!ReadExact(IO, Size, 4))
+      return End;
+
+    Position += Version == 3 ? ReadBE32(Size) + 4 : ReadSynchsafe(Size);
+  }
+
+  while (Position + FrameHeader <= End) {
+    uint8_t l_Header[10];
+
+    if (SDL_SeekIO(IO, Position, SDL_IO_SEEK_SET) < 0 || !ReadExact(IO, l_Header, FrameHeader) || l_Header[0] == 0)
+      break;
+
+    uint32_t Size;
+    uint8_t Format = 0;
+
+    if (Version == 2) {
+      Size = (uint32_t)l_Header[3] << 16 | l_Header[4] << 8 | l_Header[5];
+    } else {
+      Size = Version == 4 ? ReadSynchsafe(l_Header + 4) : ReadBE32(l_Header + 4);
+      Format = l_Header[9];
+    }
+
+    Position += FrameHeader + Size;
+
+    char *Field = TagField(Tags, (const char *)l_Header, Version == 2 ? 3 : 4);
+
+    /* Compressed or encrypted frames aren't worth it for a title */
+    bool Packed = Version == 3 ? (Format & 0xC0) : Version == 4 ? (Format & 0x0C) : false;
+
+    if (!Field || Field[0] != '\0' || Packed || Position > End)
+      continue;
+
+    size_t Length = Size < sizeof(Frame) ? Size : sizeof(Frame);
+
+    if (!ReadExact(IO, Frame, Length))
+      break;
+
+    uint8_t *Data = Frame;
+
+    if ((Version == 4 && (Format & 0x02)) || (Version < 4 && (Flags & 0x80)))
+      Length = Resync(Frame, Length);
+
+    /* v2.4 grouping byte and data length indicator */
+    if (Version == 4 && (Format & 0x40) && Length >= 1) { Data += 1; Length -= 1; }
+    if (Version == 4 && (Format & 0x01) && Length >= 4) { Data += 4; Length -= 4; }
+
+    SetID3Text(Field, Data, Length);
+  }
+
+  return End;
+}
+
+/* ID3v1 at the very end of the file, only fills what ID3v2 left empty. */
+static void ReadID3v1(SDL_IOStream *IO, AudioTags *Tags) {
+  uint8_t Tag[128];
+
+  if (SDL_SeekIO(IO, -128, SDL_IO_SEEK_END) < 0 || !ReadExact(IO, Tag, 128) || memcmp(Tag, "TAG", 3) != 0)
+    return;
+
+  if (Tags->Title[0] == '\0') SetLatin1(Tags->Title, Tag + 3, 30);
+  if (Tags->Artist[0] == '\0') SetLatin1(Tags->Artist, Tag + 33, 30);
+  if (Tags->Album[0] == '\0') SetLatin1(Tags->Album, Tag + 63, 30);
+}
+
+/* Vendor string, then a count of "KEY=value" entries, all lengths little endian. A block cut
+ * short by TAG_BLOCK_MAX is parsed as far as it goes. */
+static void ParseVorbisComment(const uint8_t *Data, size_t Length, AudioTags *Tags) {
+  if (Length < 8)
+    return;
+
+  size_t Position = 4 + (size_t)ReadLE32(Data);
+
+  if (Position + 4 > Length)
+    return;
+
+  uint32_t Count = ReadLE32(Data + Position);
+  Position += 4;
+
+  for (uint32_t i = 0; i < Count && Position + 4 <= Length; i++) {
+    size_t Entry = ReadLE32(Data + Position);
+    const uint8_t *Comment = Data + Position + 4;
+
+    Position += 4 + Entry;
+
+    if (Position > Length)
+      break;
+
+    const uint8_t *Equal = memchr(Comment, '=', Entry);
+
+    if (!Equal)
+      continue;
+
+    char *Field = TagField(Tags, (const char *)Comment, Equal - Comment);
+
+    if (Field && Field[0] == '\0')
+      SetUTF8(Field, Equal + 1, Entry - (Equal + 1 - Comment));
+  }
+}
+
+/* Reads Length bytes, capped at TAG_BLOCK_MAX, into a fresh buffer. */
+static uint8_t *ReadBlock(SDL_IOStream *IO, uint32_t *Length) {
+  *Length = *Length < TAG_BLOCK_MAX ? *Length : TAG_BLOCK_MAX;
+
+  uint8_t *Block = malloc(*Length ? *Length : 1);
+
+  if (!Block) {
+    SDL_Log("[FATAL]: Unable to allocate a tag block.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  *Length = SDL_ReadIO(IO, Block, *Length);
+  return Block;
+}
+
+/* The first 18 bytes of STREAMINFO hold the sample rate (20 bits) and sample count (36 bits). */
+static float FLACDuration(const uint8_t *Info) {
+  uint32_t Rate = (uint32_t)Info[10] << 12 | Info[11] << 4 | Info[12] >> 4;
+  uint64_t Samples = (uint64_t)(Info[13] & 0x0F) << 32 | ReadBE32(Info + 14);
+
+  return Rate ? (float)((double)Samples / Rate) : 0;
+}
+
+/* FLAC metadata blocks follow the "fLaC" marker. STREAMINFO (type 0) always comes first; block
+ * type 4 is the Vorbis comment. */
+static void ReadFLAC(SDL_IOStream *IO, AudioTags *Tags) {
+  uint8_t Header[4];
+
+  while (ReadExact(IO, Header, 4)) {
+    uint32_t Length = (uint32_t)Header[1] << 16 | Header[2] << 8 | Header[3];
+
+    if ((Header[0] & 0x7F) == 0 && Length >= 18) {
+      uint8_t Info[18];
+
+      if (!ReadExact(IO, Info, 18))
+        return;
+
+      Tags->Duration = FLACDuration(Info);
+      Length -= 18;
+    } else if ((Header[0] & 0x7F) == 4) {
+      uint8_t *Block = ReadBlock(IO, &Length);
+
+      ParseVorbisComment(Block, Length, Tags);
+      free(Block);
+      return;
+    }
+
+    if ((Header[0] & 0x80) || SDL_SeekIO(IO, Length, SDL_IO_SEEK_CUR) < 0)
+      return;
+  }
+}
+
+/* The granule position of the stream's last page is its length in samples at Rate, Opus adds the
+ * pre-skip on top. Only the end of the file is read. */
+static float OggDuration(SDL_IOStream *IO, uint32_t Serial, uint64_t Rate, uint64_t PreSkip) {
+  Sint64 Size = SDL_GetIOSize(IO);
+  uint32_t Length = Size < TAG_OGG_TAIL ? Size : TAG_OGG_TAIL;
+  float Duration = 0;
+
+  if (Size < 27 || SDL_SeekIO(IO, Size - Length, SDL_IO_SEEK_SET) < 0)
+    return 0;
+
+  uint8_t *Tail = ReadBlock(IO, &Length);
+
+  for (uint32_t i = Length >= 27 ? Length - 26 : 0; i-- > 0;) {
+    const uint8_t *Page = Tail + i;
+
+    if (memcmp(Page, "OggS", 4) != 0 || Page[4] != 0 || ReadLE32(Page + 14) != Serial || ReadLE64(Page + 6) == UINT64_MAX)
+      continue;
+
+    uint64_t Granule = ReadLE64(Page + 6);
+
+    Duration = Granule > PreSkip ? (float)((double)(Granule - PreSkip) / Rate) : 0;
+    break;
+  }
+
+  free(Tail);
+  return Duration;
+}
+
+/* The identification header sits alone on the first page and gives the granule rate. The comment
+ * header is the second logical packet of the stream, possibly spread over pages. */
+static void ReadOgg(SDL_IOStream *IO, AudioTags *Tags) {
+  uint8_t *Packet = NULL;
+  uint32_t PacketLength = 0, PacketNumber = 0, Serial = 0;
+  uint8_t Header[27], Segments[255], Identification[255];
+  size_t IdentificationLength = 0;
+
+  for (uint8_t Page = 0; Page < TAG_OGG_PAGES && PacketNumber < 2; Page++) {
+    if (!ReadExact(IO, Header, 27) || memcmp(Header, "OggS", 4) != 0 || !ReadExact(IO, Segments, Header[26]))
+      break;
+
+    if (Page == 0)
+      Serial = ReadLE32(Header + 14);
+
+    for (uint8_t i = 0; i < Header[26] && PacketNumber < 2; i++) {
+      if (Page == 0 && i == 0) {
+        IdentificationLength = SDL_ReadIO(IO, Identification, Segments[0]);
+      } else if (PacketNumber == 1 && PacketLength + Segments[i] <= TAG_BLOCK_MAX) {
+        uint8_t *l_Packet = realloc(Packet, PacketLength + Segments[i] + 1);
+
+        if (!l_Packet) {
+          SDL_Log("[FATAL]: Unable to realloc an Ogg packet.\n");
+          exit(EXIT_FAILURE);
+        }
+
+        Packet = l_Packet;
+        PacketLength += SDL_ReadIO(IO, Packet + PacketLength, Segments[i]);
+      } else if (SDL_SeekIO(IO, Segments[i], SDL_IO_SEEK_CUR) < 0) {
+        break;
+      }
+
+      if (Segments[i] < 255)
+        PacketNumber++;
+    }
+  }
+
+  uint64_t Rate = 0, PreSkip = 0;
+
+  if (IdentificationLength >= 16 && memcmp(Identification, "\x01vorbis", 7) == 0) {
+    Rate = ReadLE32(Identification + 12);
+  } else if (IdentificationLength >= 12 && memcmp(Identification, "OpusHead", 8) == 0) {
+    Rate = 48000;
+    PreSkip = Identification[10] | Identification[11] << 8;
+  } else if (IdentificationLength >= 35 && memcmp(Identification, "\x7F" "FLAC", 5) == 0) {
+    /* Mapping header (9 bytes), "fLaC", then the STREAMINFO block header and body */
+    const uint8_t *Info = Identification + 17;
+    Rate = (uint32_t)Info[10] << 12 | Info[11] << 4 | Info[12] >> 4;
+  }
+
+  if (Rate)
+    Tags->Duration = OggDuration(IO, Serial, Rate, PreSkip);
+
+  if (!Packet)
+    return;
+
+  if (PacketLength >= 7 && memcmp(Packet, "\x03vorbis", 7) == 0)
+    ParseVorbisComment(Packet + 7, PacketLength - 7, Tags);
+  else if (PacketLength >= 8 && memcmp(Packet, "OpusTags", 8) == 0)
+    ParseVorbisComment(Packet + 8, PacketLength - 8, Tags);
+  else if (PacketLength >= 4 && (Packet[0] & 0x7F) == 4) /* Ogg FLAC, a metadata block */
+    ParseVorbisComment(Packet + 4, PacketLength - 4, Tags);
+
+  free(Packet);
+}
+
+/* RIFF chunks are padded to even sizes. "fmt " gives the byte rate the "data" chunk is played at,
+ * and "LIST" chunks of type "INFO" hold the tags. */
+static void ReadRIFF(SDL_IOStream *IO, AudioTags *Tags) {
+  uint8_t Header[8];
+  uint32_t ByteRate = 0;
+
+  while (ReadExact(IO, Header, 8)) {
+    uint32_t Length = ReadLE32(Header + 4);
+    uint32_t Padded = Length + (Length & 1);
+
+    if (memcmp(Header, "fmt ", 4) == 0 && Length >= 16) {
+      uint8_t Format[16];
+
+      if (!ReadExact(IO, Format, 16))
+        return;
+
+      ByteRate = ReadLE32(Format + 8);
+      Padded -= 16;
+    } else if (memcmp(Header, "data", 4) == 0 && ByteRate) {
+      Tags->Duration = (float)((double)Length / ByteRate);
+    }
+
+    if (memcmp(Header, "LIST", 4) != 0 || Length < 4) {
+      if (SDL_SeekIO(IO, Padded, SDL_IO_SEEK_CUR) < 0)
+        return;
+
+      continue;
+    }
+
+    Sint64 Next = SDL_TellIO(IO) + Padded;
+    uint8_t *Block = ReadBlock(IO, &Length);
+
+    if (Length >= 4 && memcmp(Block, "INFO", 4) == 0) {
+      for (uint32_t Position = 4; Position + 8 <= Length;) {
+        uint32_t Size = ReadLE32(Block + Position + 4);
+        char *Field = TagField(Tags, (const char *)Block + Position, 4);
+
+        /* Compared that way round so a huge size can't wrap and stall the loop */
+        if (Size > Length - Position - 8)
+          break;
+
+        if (Field && Field[0] == '\0')
+          SetUTF8(Field, Block + Position + 8, Size);
+
+        Position += 8 + Size + (Size & 1);
+      }
+    }
+
+    free(Block);
+
+    if (SDL_SeekIO(IO, Next, SDL_IO_SEEK_SET) < 0)
+      return;
+  }
+}
+
+/* Kilobits per second by bitrate index: MPEG-1 layers I, II and III, then MPEG-2/2.5 layer I, then
+ * MPEG-2/2.5 layers II and III. */
+static const uint16_t MPEGBitrates[5][15] = {
+  {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+  {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+  {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},
+  {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+  {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}
+};
+
+static const uint16_t MPEGRates[3] = {44100, 48000, 32000};
+
+/* Length of MPEG audio from its first frame at or after Offset: the frame count of a Xing/Info or
+ * VBRI header when the encoder wrote one, otherwise the first frame's bitrate over the rest of the
+ * file, which is exact for CBR. */
+static float MPEGDuration(SDL_IOStream *IO, uint32_t Offset) {
+  Sint64 Size = SDL_GetIOSize(IO);
+  uint32_t Length = TAG_MPEG_SCAN;
+  float Duration = 0;
+
+  if (Size <= Offset || SDL_SeekIO(IO, Offset, SDL_IO_SEEK_SET) < 0)
+    return 0;
+
+  uint8_t *Data = ReadBlock(IO, &Length);
+
+  for (uint32_t i = 0; i + 4 <= Length; i++) {
+    const uint8_t *Frame = Data + i;
+
+    if (Frame[0] != 0xFF || (Frame[1] & 0xE0) != 0xE0)
+      continue;
+
+    /* Version 3 is MPEG-1, 2 MPEG-2, 0 MPEG-2.5; layer 3 is layer I, 1 is layer III */
+    uint8_t Version = Frame[1] >> 3 & 3, Layer = Frame[1] >> 1 & 3;
+    uint8_t BitrateIndex = Frame[2] >> 4, RateIndex = Frame[2] >> 2 & 3;
+
+    if (Version == 1 || Layer == 0 || BitrateIndex == 0 || BitrateIndex == 15 || RateIndex == 3)
+      continue;
+
+    bool MPEG1 = Version == 3, Mono = (Frame[3] >> 6) == 3;
+    uint32_t Rate = MPEGRates[RateIndex] >> (MPEG1 ? 0 : Version == 2 ? 1 : 2);
+    uint32_t FrameSamples = Layer == 3 ? 384 : (Layer == 1 && !MPEG1) ? 576 : 1152;
+    uint32_t Bitrate = MPEGBitrates[MPEG1 ? 3 - Layer : Layer == 3 ? 3 : 4][BitrateIndex] * 1000;
+    uint32_t Side = MPEG1 ? (Mono ? 17 : 32) : (Mono ? 9 : 17);
+    uint32_t Frames = 0;
+
+    if (i + 16 + Side <= Length && (memcmp(Frame + 4 + Side, "Xing", 4) == 0 || memcmp(Frame + 4 + Side, "Info", 4) == 0) &&
+        (ReadBE32(Frame + 8 + Side) & 1))
+      Frames = ReadBE32(Frame + 12 + Side);
+    else if (i + 54 <= Length && memcmp(Frame + 36, "VBRI", 4) == 0)
+      Frames = ReadBE32(Frame + 50);
+
+    if (Frames)
+      Duration = (float)((double)Frames * FrameSamples / Rate);
+    else
+      Duration = (float)((double)(Size - Offset - i) * 8 / Bitrate);
+
+    break;
+  }
+
+  free(Data);
+  return Duration;
+}
+
+/* Returns the format found at Offset; the stream is left right after its magic. */
+static enum TagFormat ProbeFormat(SDL_IOStream *IO, uint32_t Offset, AudioTags *Tags, bool *Known) {
+  uint8_t Magic[12];
+
+  if (SDL_SeekIO(IO, Offset, SDL_IO_SEEK_SET) < 0 || !ReadExact(IO, Magic, 12))
+    return FORMAT_UNKNOWN;
+
+  if (memcmp(Magic, "fLaC", 4) == 0) {
+    SDL_SeekIO(IO, Offset + 4, SDL_IO_SEEK_SET);
+    return FORMAT_FLAC;
+  }
+
+  if (Offset == 0 && memcmp(Magic, "OggS", 4) == 0) {
+    SDL_SeekIO(IO, 0, SDL_IO_SEEK_SET);
+    ReadOgg(IO, Tags);
+    *Known = true;
+  } else if (Offset == 0 && memcmp(Magic, "RIFF", 4) == 0 && memcmp(Magic + 8, "WAVE", 4) == 0) {
+    ReadRIFF(IO, Tags);
+    *Known = true;
+  } else if (Magic[0] == 0xFF && (Magic[1] & 0xE0) == 0xE0 && (Magic[1] & 0x06) != 0) {
+    return FORMAT_MPEG;
+  }
+
+  return FORMAT_UNKNOWN;
+}
+
+static bool ReadNativeTags(const char *Path, AudioTags *Tags, bool *Readable) {
+  SDL_IOStream *IO = SDL_IOFromFile(Path, "rb");
+  bool Known = false;
+
+  *Readable = IO != NULL;
+
+  if (!IO)
+    return false;
+
+  uint32_t Offset = ReadID3v2(IO, Tags);
+
+  switch (ProbeFormat(IO, Offset, Tags, &Known)) {
+    case FORMAT_FLAC:
+      ReadFLAC(IO, Tags);
+      Known = true;
+      break;
+    case FORMAT_MPEG:
+      Tags->Duration = MPEGDuration(IO, Offset);
+      ReadID3v1(IO, Tags);
+      Known = true;
+      break;
+    default:
+      /* An ID3v2 tag followed by padding or junk is still most likely MPEG audio */
+      if (Offset != 0 && !Known) {
+        Tags->Duration = MPEGDuration(IO, Offset);
+        ReadID3v1(IO, Tags);
+        Known = true;
+      }
+      break;
+  }
+
+  SDL_CloseIO(IO);
+  return Known;
+}
+
+/* Extensions that are never audio (artwork, rips' side files, playlists) and ones SDL_mixer plays
+ * without a magic number we can check for. Both lists are lowercase. */
+static const char *NonAudioExtensions[] = {
+  "jpg", "jpeg", "png", "gif", "bmp", "webp", "tif", "tiff", "ico", "txt", "nfo", "cue", "log", "md5",
+  "sfv", "ffp", "accurip", "m3u", "m3u8", "pls", "pdf", "htm", "html", "url", "ini", "db", "lrc", "sh",
+  "exe", "dll", "zip", "rar", "7z", "iso", "nzb", "torrent", "xml", "json", "mkv", "avi", "mp4v"
+};
+
+static const char *AudioExtensions[] = {
+  "mp3", "mp2", "aac", "mod", "s3m", "xm", "it", "669", "med", "mtm", "stm", "ult", "voc"
+};
+
+static bool HasExtension(const char *Path, const char **List, uint8_t Count) {
+  const char *Dot = strrchr(Path, '.');
+
+  if (!Dot || strchr(Dot, '/') || strchr(Dot, '\\'))
+    return false;
+
+  for (uint8_t i = 0; i < Count; i++) {
+    if (SDL_strcasecmp(Dot + 1, List[i]) == 0)
+      return true;
+  }
+
+  return false;
+}
+
+/* Classifies a file from its extension and first bytes, before any tag reader or decoder sees it. */
+bool SA_IsAudioFile(const char *Path) {
+  if (HasExtension(Path, NonAudioExtensions, SDL_arraysize(NonAudioExtensions)))
+    return false;
+
+  SDL_IOStream *IO = SDL_IOFromFile(Path, "rb");
+  uint8_t Magic[16] = {0};
+
+  if (!IO)
+    return false;
+
+  size_t Length = SDL_ReadIO(IO, Magic, sizeof(Magic));
+  SDL_CloseIO(IO);
+
+  if (Length < 4)
+    return false;
+
+  if (memcmp(Magic, "ID3", 3) == 0 || memcmp(Magic, "fLaC", 4) == 0 || memcmp(Magic, "OggS", 4) == 0 ||
+      memcmp(Magic, "MThd", 4) == 0 || memcmp(Magic, "IMPM", 4) == 0 || memcmp(Magic, "wvpk", 4) == 0 ||
+      memcmp(Magic, "MAC ", 4) == 0 || memcmp(Magic, "Extended Module", 15) == 0)
+    return true;
+
+  /* RIFF WAVE, AIFF(-C) and MP4/M4A containers */
+  if (Length >= 12 && ((memcmp(Magic, "RIFF", 4) == 0 && memcmp(Magic + 8, "WAVE", 4) == 0) ||
+                       (memcmp(Magic, "FORM", 4) == 0 && memcmp(Magic + 8, "AIF", 3) == 0) ||
+                       memcmp(Magic + 4, "ftyp", 4) == 0))
+    return true;
+
+  /* MPEG audio or ADTS sync word */
+  if (Magic[0] == 0xFF && (Magic[1] & 0xE0) == 0xE0 && (Magic[1] & 0x18) != 0x08)
+    return true;
+
+  return HasExtension(Path, AudioExtensions, SDL_arraysize(AudioExtensions));
+}
+
+/* Fills Tags from the file headers, or through SDL_mixer for formats it doesn't know. Returns
+ * false if the file can't be read or isn't audio SDL_mixer understands. */
+bool SA_ReadTags(const char *Path, AudioTags *Tags) {
+  bool Readable;
+
+  memset(Tags, 0, sizeof(AudioTags));
+
+  if (ReadNativeTags(Path, Tags, &Readable))
+    return true;
+
+  if (!Readable)
+    return false;
+
+  memset(Tags, 0, sizeof(AudioTags));
+  Mix_Music *l_Music = Mix_LoadMUS(Path);
+
+  if (!l_Music)
+    return false;
+
+  const char *Fields[4] = {Mix_GetMusicTitle(l_Music), Mix_GetMusicArtistTag(l_Music), Mix_GetMusicAlbumTag(l_Music),
+                           Mix_GetMusicCopyrightTag(l_Music)};
+  char *Dest[4] = {Tags->Title, Tags->Artist, Tags->Album, Tags->Copyright};
+
+  for (uint8_t i = 0; i < 4; i++) {
+    if (Fields[i])
+      SetUTF8(Dest[i], (const uint8_t *)Fields[i], strlen(Fields[i]));
+  }
+
+  double Duration = Mix_MusicDuration(l_Music);
+  Tags->Duration = Duration > 0 ? Duration : 0;
+
+  Mix_FreeMusic(l_Music);
+  return true;
+}
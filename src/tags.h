@@ -0,0 +1,27 @@
+#ifndef __SATAGS__
+#define __SATAGS__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Reads track metadata straight from the container headers: ID3v2/ID3v1 (MPEG), Vorbis comments
+ * (FLAC, Ogg Vorbis, Opus and Ogg FLAC) and RIFF INFO (WAVE). Only the tag bytes are read, no
+ * decoder is set up. Other formats go through Mix_LoadMUS. Strings are UTF-8, cut at TAG_LENGTH.
+ * The duration comes from the same headers: FLAC STREAMINFO, the last Ogg granule position, the
+ * WAVE data size, or the Xing/VBRI frame count of MPEG audio (its bitrate for CBR files).
+ */
+#define TAG_LENGTH 256
+
+typedef struct {
+  char Title[TAG_LENGTH];
+  char Artist[TAG_LENGTH];
+  char Album[TAG_LENGTH];
+  char Copyright[TAG_LENGTH];
+  float Duration; /* Seconds, 0 when unknown */
+} AudioTags;
+
+bool SA_IsAudioFile(const char *Path);
+bool SA_ReadTags(const char *Path, AudioTags *Tags);
+
+#endif
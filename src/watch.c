@@ -0,0 +1,628 @@
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef WINDOWS
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "arena.h"
+#include "audio.h"
+#include "cache.h"
+#include "category.h"
+#include "import.h"
+#include "watch.h"
+
+/* How long the disk must stay quiet before a batch is applied, the longest a steady stream of
+ * changes may hold a batch back, and how often roots are rescanned when inotify can't be used. */
+#define WATCH_SETTLE_NS   (500 * 1000000ULL)
+#define WATCH_MAX_HOLD_NS (3000 * 1000000ULL)
+#define WATCH_RESCAN_NS   (60 * 1000000000ULL)
+
+/* Sorted in the order a batch applies them: a directory deleted and created again is emptied
+ * before it is walked. */
+enum WatchType {
+  WATCH_GONE,      /* A directory deleted or moved away, with every track under it */
+  WATCH_DIRECTORY, /* A directory created or moved in */
+  WATCH_CHANGED    /* A file written, deleted or moved */
+};
+
+typedef struct WatchEvent {
+  struct WatchEvent *Next;
+  uint8_t Type;
+  uint8_t Category;
+  char Path[];
+} WatchEvent;
+
+typedef struct {
+  char *Path;
+  uint8_t Category;
+} WatchRoot;
+
+static WatchRoot *Roots;
+static uint32_t RootCount;
+static uint64_t LastRescan;
+
+/* Events are collected by the watch thread and taken as one batch by the main thread. */
+static SDL_Mutex *WatchLock;
+static WatchEvent *Events, *LastEvent;
+static uint64_t FirstEventTime, LastEventTime;
+static SDL_AtomicInt Fallback, Overflow;
+
+static WatchEvent *NewEvent(const char *Path, uint8_t Type, uint8_t Category) {
+  size_t Length = strlen(Path) + 1;
+  WatchEvent *Event = malloc(sizeof(WatchEvent) + Length);
+
+  if (!Event) {
+    SDL_Log("[FATAL]: Unable to allocate a watch event.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  Event->Next = NULL;
+  Event->Type = Type;
+  Event->Category = Category;
+  memcpy(Event->Path, Path, Length);
+
+  return Event;
+}
+
+static void ChainEvent(WatchEvent **First, WatchEvent **Last, WatchEvent *Event) {
+  if (*Last)
+    (*Last)->Next = Event;
+  else
+    *First = Event;
+
+  *Last = Event;
+}
+
+static void FreeEvents(WatchEvent *Event) {
+  while (Event) {
+    WatchEvent *Next = Event->Next;
+    free(Event);
+    Event = Next;
+  }
+}
+
+#ifndef WINDOWS
+#define WATCH_MASK (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+typedef struct {
+  int Descriptor;
+  uint8_t Category;
+  bool Root;
+  char *Path;
+} WatchedDirectory;
+
+static int Notify = -1;
+static SDL_Thread *Thread;
+static SDL_AtomicInt Quit;
+
+/* Only the watch thread touches these. Sorted by descriptor. */
+static WatchedDirectory *Watched;
+static uint32_t WatchedCount, WatchedCapacity;
+
+/* Roots handed over by the main thread, under WatchLock */
+static WatchEvent *Requests, *LastRequest;
+
+static uint32_t FindWatched(int Descriptor) {
+  uint32_t Low = 0, High = WatchedCount;
+
+  while (Low < High) {
+    uint32_t Middle = (Low + High) / 2;
+
+    if (Watched[Middle].Descriptor < Descriptor)
+      Low = Middle + 1;
+    else
+      High = Middle;
+  }
+
+  return Low;
+}
+
+static void DropWatched(uint32_t Slot) {
+  free(Watched[Slot].Path);
+  memmove(Watched + Slot, Watched + Slot + 1, sizeof(WatchedDirectory) * (WatchedCount - Slot - 1));
+  WatchedCount--;
+}
+
+/* Watches Path and every directory below it. A directory already watched keeps its descriptor and
+ * only takes the new path, which is how a move inside the tree is followed. */
+static void AddWatches(const char *Path, uint8_t Category, bool Root) {
+  int Descriptor = inotify_add_watch(Notify, Path, WATCH_MASK);
+
+  if (Descriptor == -1) {
+    if (errno == ENOSPC && !SDL_GetAtomicInt(&Fallback)) {
+      SDL_Log("Out of inotify watches, watched directories will be rescanned every minute instead.");
+      SDL_SetAtomicInt(&Fallback, 1);
+    }
+
+    return;
+  }
+
+  size_t PathLen = strlen(Path);
+  char *Copy = malloc(PathLen + 1);
+
+  if (!Copy) {
+    SDL_Log("[FATAL]: Unable to allocate a watched path.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  memcpy(Copy, Path, PathLen + 1);
+  uint32_t Slot = FindWatched(Descriptor);
+
+  if (Slot < WatchedCount && Watched[Slot].Descriptor == Descriptor) {
+    Root = Root || Watched[Slot].Root;
+    free(Watched[Slot].Path);
+  } else {
+    if (WatchedCount == WatchedCapacity) {
+      WatchedCapacity = WatchedCapacity ? WatchedCapacity * 2 : 64;
+      WatchedDirectory *l_Watched = realloc(Watched, sizeof(WatchedDirectory) * WatchedCapacity);
+
+      if (!l_Watched) {
+        SDL_Log("[FATAL]: Unable to realloc the watched directories.\n");
+        exit(EXIT_FAILURE);
+      }
+
+      Watched = l_Watched;
+    }
+
+    memmove(Watched + Slot + 1, Watched + Slot, sizeof(WatchedDirectory) * (WatchedCount - Slot));
+    WatchedCount++;
+  }
+
+  Watched[Slot] = (WatchedDirectory){Descriptor, Category, Root, Copy};
+
+  DIR *Directory = opendir(Path);
+  char FullPath[PATH_MAX];
+  struct dirent *Entry;
+
+  if (!Directory)
+    return;
+
+  while (PathLen > 1 && Path[PathLen - 1] == '/')
+    PathLen--;
+
+  memcpy(FullPath, Path, PathLen);
+  FullPath[PathLen] = '/';
+
+  /* Same rules as the import: no hidden directories, no linked ones */
+  while ((Entry = readdir(Directory)) != NULL) {
+    const char *Name = Entry->d_name;
+    size_t NameLen = strlen(Name);
+    uint8_t Type = Entry->d_type;
+
+    if (Name[0] == '.' || PathLen + NameLen + 2 > sizeof(FullPath))
+      continue;
+
+    if (Type == DT_UNKNOWN) {
+      struct stat Stats;
+
+      if (fstatat(dirfd(Directory), Name, &Stats, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(Stats.st_mode))
+        Type = DT_DIR;
+    }
+
+    if (Type != DT_DIR)
+      continue;
+
+    memcpy(FullPath + PathLen + 1, Name, NameLen + 1);
+    AddWatches(FullPath, Category, false);
+  }
+
+  closedir(Directory);
+}
+
+/* A directory moved away is still watched wherever it went, so it and everything below it are let go. */
+static void RemoveWatches(const char *Path) {
+  size_t PathLen = strlen(Path);
+
+  for (uint32_t i = 0; i < WatchedCount;) {
+    const char *WatchedPath = Watched[i].Path;
+
+    if (strncmp(WatchedPath, Path, PathLen) == 0 && (WatchedPath[PathLen] == '\0' || WatchedPath[PathLen] == '/')) {
+      inotify_rm_watch(Notify, Watched[i].Descriptor);
+      DropWatched(i);
+    } else {
+      i++;
+    }
+  }
+}
+
+static void ReadEvents() {
+  char Buffer[16384] __attribute__((aligned(__alignof__(struct inotify_event))));
+  char FullPath[PATH_MAX];
+  WatchEvent *First = NULL, *Last = NULL;
+  ssize_t Length;
+
+  while ((Length = read(Notify, Buffer, sizeof(Buffer))) > 0) {
+    const struct inotify_event *Event = NULL;
+
+    for (char *Pointer = Buffer; Pointer < Buffer + Length; Pointer += sizeof(struct inotify_event) + Event->len) {
+      Event = (const struct inotify_event *)Pointer;
+
+      /* The kernel dropped events, only a full rescan can tell what they were */
+      if (Event->mask & IN_Q_OVERFLOW) {
+        SDL_SetAtomicInt(&Overflow, 1);
+        continue;
+      }
+
+      uint32_t Slot = FindWatched(Event->wd);
+
+      if (Slot == WatchedCount || Watched[Slot].Descriptor != Event->wd)
+        continue;
+
+      if (Event->mask & IN_IGNORED) {
+        DropWatched(Slot);
+        continue;
+      }
+
+      /* Nothing watches a root's parent, so this is the only word of it being deleted or moved
+       * away. Below a root the parent's event already covers it. */
+      if (Event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+        if (Watched[Slot].Root) {
+          WatchEvent *Gone = NewEvent(Watched[Slot].Path, WATCH_GONE, Watched[Slot].Category);
+          size_t PathLen = strlen(Gone->Path);
+
+          while (PathLen > 1 && Gone->Path[PathLen - 1] == '/')
+            Gone->Path[--PathLen] = '\0';
+
+          ChainEvent(&First, &Last, Gone);
+          RemoveWatches(Gone->Path);
+        }
+
+        continue;
+      }
+
+      if (Event->len == 0 || Event->name[0] == '.')
+        continue;
+
+      uint8_t Category = Watched[Slot].Category;
+
+      if ((size_t)snprintf(FullPath, sizeof(FullPath), "%s/%s", Watched[Slot].Path, Event->name) >= sizeof(FullPath))
+        continue;
+
+      if (Event->mask & IN_ISDIR) {
+        if (Event->mask & (IN_CREATE | IN_MOVED_TO)) {
+          AddWatches(FullPath, Category, false);
+          ChainEvent(&First, &Last, NewEvent(FullPath, WATCH_DIRECTORY, Category));
+        } else if (Event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+          if (Event->mask & IN_MOVED_FROM)
+            RemoveWatches(FullPath);
+
+          ChainEvent(&First, &Last, NewEvent(FullPath, WATCH_GONE, Category));
+        }
+      } else if (!(Event->mask & IN_CREATE)) {
+        /* A new file is picked up once it is closed, not while it is still being written */
+        ChainEvent(&First, &Last, NewEvent(FullPath, WATCH_CHANGED, Category));
+      }
+    }
+  }
+
+  if (!First)
+    return;
+
+  SDL_LockMutex(WatchLock);
+  LastEventTime = SDL_GetTicksNS();
+
+  if (!Events)
+    FirstEventTime = LastEventTime;
+
+  if (LastEvent)
+    LastEvent->Next = First;
+  else
+    Events = First;
+
+  LastEvent = Last;
+  SDL_UnlockMutex(WatchLock);
+}
+
+static int WatchThread(void *Data) {
+  (void)Data;
+  struct pollfd Poll = {Notify, POLLIN, 0};
+
+  while (!SDL_GetAtomicInt(&Quit)) {
+    SDL_LockMutex(WatchLock);
+    WatchEvent *Request = Requests;
+    Requests = LastRequest = NULL;
+    SDL_UnlockMutex(WatchLock);
+
+    for (WatchEvent *Next; Request; Request = Next) {
+      Next = Request->Next;
+      AddWatches(Request->Path, Request->Category, true);
+      free(Request);
+    }
+
+    if (poll(&Poll, 1, 250) > 0)
+      ReadEvents();
+  }
+
+  for (uint32_t i = 0; i < WatchedCount; i++)
+    free(Watched[i].Path);
+
+  free(Watched);
+  return 0;
+}
+#endif
+
+static void AddRoot(const char *Path, uint8_t Category) {
+  size_t Length = strlen(Path) + 1;
+  WatchRoot *l_Roots = realloc(Roots, sizeof(WatchRoot) * (RootCount + 1));
+  char *Copy = malloc(Length);
+
+  if (!l_Roots || !Copy) {
+    SDL_Log("[FATAL]: Unable to realloc the watched roots.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  memcpy(Copy, Path, Length);
+  Roots = l_Roots;
+  Roots[RootCount++] = (WatchRoot){Copy, Category};
+
+  #ifndef WINDOWS
+  if (Notify != -1) {
+    SDL_LockMutex(WatchLock);
+    ChainEvent(&Requests, &LastRequest, NewEvent(Path, WATCH_DIRECTORY, Category));
+    SDL_UnlockMutex(WatchLock);
+  }
+  #endif
+}
+
+/* One root per line: the category name, a tab, then the path. */
+static void LoadRoots() {
+  char *Path = SA_CachePath(WATCH_FILE);
+
+  if (!Path)
+    return;
+
+  char *Data = SDL_LoadFile(Path, NULL);
+  free(Path);
+
+  if (!Data)
+    return;
+
+  for (char *Line = Data, *End; *Line; Line = End) {
+    End = Line + strcspn(Line, "\n");
+
+    if (*End)
+      *End++ = '\0';
+
+    char *Tab = strchr(Line, '\t');
+
+    if (!Tab || Tab[1] == '\0')
+      continue;
+
+    *Tab = '\0';
+    int32_t Category = SA_FindCategory(Line);
+
+    AddRoot(Tab + 1, Category == -1 ? 0 : Category);
+  }
+
+  SDL_free(Data);
+}
+
+static void SaveRoots() {
+  char *Path = SA_CachePath(WATCH_FILE);
+
+  if (!Path)
+    return;
+
+  SDL_IOStream *IO = SDL_IOFromFile(Path, "wb");
+
+  if (!IO) {
+    SDL_Log("Unable to save the watched directories: %s", SDL_GetError());
+    free(Path);
+    return;
+  }
+
+  for (uint32_t i = 0; i < RootCount; i++)
+    SDL_IOprintf(IO, "%s\t%s\n", SA_String(Categories[Roots[i].Category].Name), Roots[i].Path);
+
+  SDL_CloseIO(IO);
+  free(Path);
+}
+
+/* Known tracks are checked against their stamps, and every root is walked for new files. */
+static void Rescan() {
+  SA_ImportValidateLibrary();
+
+  for (uint32_t i = 0; i < RootCount; i++)
+    SA_ImportRescan(Roots[i].Path, Roots[i].Category);
+}
+
+static int CompareEvents(const void *A, const void *B) {
+  const WatchEvent *EventA = *(WatchEvent *const *)A, *EventB = *(WatchEvent *const *)B;
+  int Order = strcmp(EventA->Path, EventB->Path);
+
+  return Order ? Order : EventA->Type - EventB->Type;
+}
+
+static int CompareGone(const void *Key, const void *Entry) {
+  return strcmp(Key, *(const char *const *)Entry);
+}
+
+/* Removes every track below one of the Gone directories (sorted). Each track path is looked up once
+ * per separator, so a whole tree deleted at once doesn't cost a library pass per directory. */
+static void RemoveGone(const char **Gone, uint32_t Count) {
+  char Path[PATH_MAX];
+
+  for (uint32_t i = 0; i < SA_TotalAudio; i++) {
+    if (Audio[i].Path == 0)
+      continue;
+
+    const char *TrackPath = SA_String(Audio[i].Path);
+    size_t Length = strlen(TrackPath);
+
+    if (Length >= sizeof(Path))
+      continue;
+
+    memcpy(Path, TrackPath, Length + 1);
+
+    for (size_t j = Length; j-- > 1;) {
+      if (Path[j] != '/')
+        continue;
+
+      Path[j] = '\0';
+
+      if (bsearch(Path, Gone, Count, sizeof(const char *), CompareGone)) {
+        AudioRemove(i);
+        break;
+      }
+    }
+  }
+}
+
+/*
+ * Applies one batch. Duplicates are dropped first: copying a file alone reports it several times.
+ * Files and new directories go to the import workers, whose results land in a single playlist
+ * refresh once they are all in; tracks under deleted directories are removed right here.
+ */
+static void ApplyBatch(WatchEvent *Batch) {
+  uint32_t Count = 0, GoneCount = 0;
+
+  for (WatchEvent *Event = Batch; Event; Event = Event->Next)
+    Count++;
+
+  WatchEvent **Sorted = malloc(sizeof(WatchEvent *) * Count);
+  const char **Gone = malloc(sizeof(const char *) * Count);
+
+  if (!Sorted || !Gone) {
+    SDL_Log("[FATAL]: Unable to allocate a watch batch.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  Count = 0;
+
+  for (WatchEvent *Event = Batch; Event; Event = Event->Next)
+    Sorted[Count++] = Event;
+
+  qsort(Sorted, Count, sizeof(WatchEvent *), CompareEvents);
+
+  for (uint32_t i = 0; i < Count; i++) {
+    WatchEvent *Event = Sorted[i];
+
+    if (i > 0 && CompareEvents(&Sorted[i - 1], &Sorted[i]) == 0)
+      continue;
+
+    if (Event->Type == WATCH_GONE)
+      Gone[GoneCount++] = Event->Path;
+    else if (Event->Type == WATCH_DIRECTORY)
+      SA_ImportRescan(Event->Path, Event->Category);
+    else
+      SA_ImportChanged(Event->Path, Event->Category);
+  }
+
+  if (GoneCount) {
+    SA_BeginAudioBatch();
+    RemoveGone(Gone, GoneCount);
+    SA_CommitAudioBatch();
+  }
+
+  free(Gone);
+  free(Sorted);
+  FreeEvents(Batch);
+}
+
+void InitializeWatch() {
+  WatchLock = SDL_CreateMutex();
+
+  if (!WatchLock) {
+    SDL_Log("[FATAL]: Unable to create the watch lock: %s\n", SDL_GetError());
+    exit(EXIT_FAILURE);
+  }
+
+  #ifndef WINDOWS
+  Notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  if (Notify != -1)
+    Thread = SDL_CreateThread(WatchThread, "SA_Watch", NULL);
+
+  if (!Thread) {
+    SDL_Log("Unable to watch directories, they will be rescanned every minute instead.");
+
+    if (Notify != -1)
+      close(Notify);
+
+    Notify = -1;
+    SDL_SetAtomicInt(&Fallback, 1);
+  }
+  #else
+  SDL_SetAtomicInt(&Fallback, 1);
+  #endif
+
+  LoadRoots();
+
+  /* Catch up with files added while the program was closed; the cache already checks the rest */
+  for (uint32_t i = 0; i < RootCount; i++)
+    SA_ImportRescan(Roots[i].Path, Roots[i].Category);
+
+  LastRescan = SDL_GetTicksNS();
+}
+
+void ShutdownWatch() {
+  #ifndef WINDOWS
+  if (Thread) {
+    SDL_SetAtomicInt(&Quit, 1);
+    SDL_WaitThread(Thread, NULL);
+    close(Notify);
+  }
+
+  FreeEvents(Requests);
+  #endif
+
+  FreeEvents(Events);
+
+  for (uint32_t i = 0; i < RootCount; i++)
+    free(Roots[i].Path);
+
+  free(Roots);
+  SDL_DestroyMutex(WatchLock);
+}
+
+void SA_WatchDirectory(const char *Path, uint8_t Category) {
+  for (uint32_t i = 0; i < RootCount; i++) {
+    if (strcmp(Roots[i].Path, Path) == 0)
+      return;
+  }
+
+  AddRoot(Path, Category);
+  SaveRoots();
+}
+
+void SA_WatchPoll() {
+  static bool RescanDue = false;
+  uint64_t Now = SDL_GetTicksNS();
+
+  if (SDL_GetAtomicInt(&Overflow) || (SDL_GetAtomicInt(&Fallback) && Now - LastRescan > WATCH_RESCAN_NS)) {
+    SDL_SetAtomicInt(&Overflow, 0);
+    RescanDue = true;
+  }
+
+  /* Not on top of a running import, it will be caught on the next pass anyway */
+  if (RescanDue && SA_ImportIdle()) {
+    RescanDue = false;
+    LastRescan = Now;
+
+    if (RootCount)
+      Rescan();
+  }
+
+  SDL_LockMutex(WatchLock);
+  Now = SDL_GetTicksNS();
+
+  if (!Events || (Now - LastEventTime < WATCH_SETTLE_NS && Now - FirstEventTime < WATCH_MAX_HOLD_NS)) {
+    SDL_UnlockMutex(WatchLock);
+    return;
+  }
+
+  WatchEvent *Batch = Events;
+  Events = LastEvent = NULL;
+  SDL_UnlockMutex(WatchLock);
+
+  ApplyBatch(Batch);
+}
@@ -0,0 +1,20 @@
+#ifndef __SAWATCH__
+#define __SAWATCH__
+
+#include <stdint.h>
+
+/*
+ * Keeps imported directories in sync with the disk. A thread follows every directory under the
+ * watched roots with inotify and collects what changed; the main loop applies it through the
+ * import workers once the disk has been quiet for a moment, so a bulk copy lands as one batch.
+ * Without inotify (Windows, or once the watch limit is reached) the roots are rescanned instead.
+ * Roots are kept in watch.txt in the pref path.
+ */
+#define WATCH_FILE "watch.txt"
+
+void InitializeWatch();
+void ShutdownWatch();
+void SA_WatchDirectory(const char *Path, uint8_t Category);
+void SA_WatchPoll();
+
+#endif